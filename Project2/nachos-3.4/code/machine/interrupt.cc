@@ -23,6 +23,9 @@
 #include "copyright.h"
 #include "interrupt.h"
 #include "system.h"
+#ifdef USER_PROGRAM
+#include "profile.h"
+#endif
 
 // String definitions for debugging messages
 
@@ -62,8 +65,9 @@ Interrupt::Interrupt()
     level = IntOff;
     pending = new List();
     inHandler = FALSE;
-    yieldOnReturn = FALSE;
+    yieldOnReturn = keepPlaceOnReturn = FALSE;
     status = SystemMode;
+    UpdateNextDue();
 }
 
 //----------------------------------------------------------------------
@@ -171,13 +175,36 @@ Interrupt::OneTick()
     ChangeLevel(IntOff, IntOn);		// re-enable interrupts
     if (yieldOnReturn) {		// if the timer device handler asked 
 					// for a context switch, ok to do it now
-	yieldOnReturn = FALSE;
+	bool keepPlace = keepPlaceOnReturn;
+
+	yieldOnReturn = keepPlaceOnReturn = FALSE;
  	status = SystemMode;		// yield is a kernel routine
-	currentThread->Yield();
+	currentThread->Yield(keepPlace);
 	status = old;
     }
 }
 
+//----------------------------------------------------------------------
+// Interrupt::UpdateNextDue
+// 	Recompute the time at which the earliest pending interrupt is
+//	due, or a time far in the future if nothing is pending.  OneTick
+//	will not invoke any handler before then, so the simulator can 
+//	run that many user instructions with the ticks counted inline 
+//	(see ONE_USER_TICK).
+//
+//	When tracing ticks, pretend something is always due, so that
+//	every tick goes through OneTick and gets printed.
+//----------------------------------------------------------------------
+
+void
+Interrupt::UpdateNextDue()
+{
+    if (DebugIsEnabled('i'))
+	nextDue = 0;
+    else if (pending->SortedPeek(&nextDue) == NULL)
+	nextDue = 0x7fffffff;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::YieldOnReturn
 // 	Called from within an interrupt handler, to cause a context switch
@@ -187,12 +214,17 @@ Interrupt::OneTick()
 //	We can't do the context switch here, because that would switch
 //	out the interrupt handler, and we want to switch out the 
 //	interrupted thread.
+//
+//	If "keepPlace", the interrupted thread only stands aside for
+//	whichever thread is first on the ready list, and then runs again
+//	(see Thread::Yield); a time slice, if there is one, wins.
 //----------------------------------------------------------------------
 
 void
-Interrupt::YieldOnReturn()
+Interrupt::YieldOnReturn(bool keepPlace)
 { 
     ASSERT(inHandler == TRUE);  
+    keepPlaceOnReturn = keepPlace && (!yieldOnReturn || keepPlaceOnReturn);
     yieldOnReturn = TRUE; 
 }
 
@@ -242,6 +274,9 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+#ifdef USER_PROGRAM
+    PrintProfiles();
+#endif
     Cleanup();     // Never returns.
 }
 
@@ -272,6 +307,7 @@ Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
     ASSERT(fromNow > 0);
 
     pending->SortedInsert(toOccur, when);
+    UpdateNextDue();
 }
 
 //----------------------------------------------------------------------
@@ -299,6 +335,7 @@ Interrupt::CheckIfDue(bool advanceClock)
 	DumpState();
     PendingInterrupt *toOccur = 
 		(PendingInterrupt *)pending->SortedRemove(&when);
+    UpdateNextDue();
 
     if (toOccur == NULL)		// no pending interrupts
 	return FALSE;			
@@ -308,6 +345,7 @@ Interrupt::CheckIfDue(bool advanceClock)
 	stats->totalTicks = when;
     } else if (when > stats->totalTicks) {	// not time yet, put it back
 	pending->SortedInsert(toOccur, when);
+	UpdateNextDue();
 	return FALSE;
     }
 
@@ -315,6 +353,7 @@ Interrupt::CheckIfDue(bool advanceClock)
     if ((status == IdleMode) && (toOccur->type == TimerInt) 
 				&& pending->IsEmpty()) {
 	 pending->SortedInsert(toOccur, when);
+	 UpdateNextDue();
 	 return FALSE;
     }
 
@@ -92,13 +92,18 @@ class Interrupt {
 
     void Halt(); 			// quit and print out stats
     
-    void YieldOnReturn();		// cause a context switch on return 
+    void YieldOnReturn(bool keepPlace = FALSE);
+					// cause a context switch on return 
 					// from an interrupt handler
 
     MachineStatus getStatus() { return status; } // idle, kernel, user
     void setStatus(MachineStatus st) { status = st; }
 
     void DumpState();			// Print interrupt state
+
+    int NextDue() { return nextDue; }	// Time the next pending interrupt
+					// is due, so the simulator knows
+					// how far it can run without one
     
 
     // NOTE: the following are internal to the hardware simulation code.
@@ -113,10 +118,14 @@ class Interrupt {
     void OneTick();       		// Advance simulated time
 
   private:
+    int nextDue;		// NextDue(), kept up to date whenever
+				// "pending" changes
     IntStatus level;		// are interrupts enabled or disabled?
     List *pending;		// the list of interrupts scheduled
 				// to occur in the future
     bool inHandler;		// TRUE if we are running an interrupt handler
+    bool keepPlaceOnReturn;	// ... and the interrupted thread is to
+				// run again next
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
     MachineStatus status;	// idle, kernel mode, user mode
@@ -125,9 +134,22 @@ class Interrupt {
 
     bool CheckIfDue(bool advanceClock); // Check if an interrupt is supposed
 					// to occur now
+    void UpdateNextDue();		// Recompute "nextDue"
 
     void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
 	IntStatus now);  		// simulated time
 };
 
+// Advance simulated time by one user instruction.  Unless an interrupt
+// is due by then, all OneTick would do is bump the tick counts, so the
+// simulator's run loops do that themselves and skip the call.
+
+#define ONE_USER_TICK() {						\
+	if (stats->totalTicks + UserTick < interrupt->NextDue()) {	\
+	    stats->totalTicks += UserTick;				\
+	    stats->userTicks += UserTick;				\
+	} else								\
+	    interrupt->OneTick();					\
+    }
+
 #endif // INTERRRUPT_H
@@ -13,6 +13,9 @@
 
 // Textual names of the exceptions that can be generated by user program
 // execution, for debugging.
+int pageSize = SectorSize;		// see machine.h
+int numPhysPages = DefaultPhysPages;
+
 static char* exceptionNames[] = { "no exception", "syscall", 
 				"page fault/no TLB entry", "page read only",
 				"bus error", "address error", "overflow",
@@ -60,15 +63,26 @@ Machine::Machine(bool debug)
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
+    decodeCache = new Instruction[MemorySize / 4];
+    blockCache = new Block *[MemorySize / 4];
+    blockCode = new Instruction *[InstrsPerPage];
+    for (i = 0; i < MemorySize / 4; i++) {
+	decodeCache[i].opCode = 0;
+	blockCache[i] = NULL;
+    }
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-	tlb[i].valid = FALSE;
-    pageTable = NULL;
+    tlb = NULL;
+    EnableTLB(TLBSize);
 #else	// use linear page table
     tlb = NULL;
+    tlbSize = 0;
     pageTable = NULL;
 #endif
+    radixTable = NULL;
+
+    tlbAsid = 0;
+    FlushMicroTLB();
+    profile = NULL;
 
     singleStep = debug;
     CheckEndian();
@@ -81,11 +95,40 @@ Machine::Machine(bool debug)
 
 Machine::~Machine()
 {
+    for (int i = 0; i < NumPhysPages; i++)
+	DropBlocks(i);
     delete [] mainMemory;
+    delete [] decodeCache;
+    delete [] blockCache;
+    delete [] blockCode;
     if (tlb != NULL)
         delete [] tlb;
 }
 
+//----------------------------------------------------------------------
+// Machine::EnableTLB
+// 	Switch to translating user addresses through a software-loaded
+//	TLB, which the kernel refills from its own page tables on each
+//	PageFaultException (see AddrSpace::HandleTLBMiss).  The page 
+//	table pointer must then be left NULL.
+//
+//	"size" -- the number of TLB entries
+//----------------------------------------------------------------------
+
+void
+Machine::EnableTLB(int size)
+{
+    if (tlb != NULL)
+	delete [] tlb;
+    tlbSize = size;
+    tlb = new TranslationEntry[size];
+    for (int i = 0; i < size; i++) {
+	tlb[i].valid = FALSE;
+	tlb[i].asid = 0;
+    }
+    pageTable = NULL;
+}
+
 //----------------------------------------------------------------------
 // Machine::RaiseException
 // 	Transfer control to the Nachos kernel from user mode, because
@@ -109,6 +152,26 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
     interrupt->setStatus(UserMode);
 }
 
+//----------------------------------------------------------------------
+// Machine::InvalidateFrame
+// 	Drop the predecoded instructions and translated blocks for one
+//	physical page.  The kernel must call this whenever it refills a
+//	frame behind the simulator's back (eg, reading a page in from 
+//	swap); stores made by user code go through NoteWrite instead.
+//
+//	"pPage" -- the physical page whose contents are changing
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateFrame(int pPage)
+{
+    Instruction *instr = &decodeCache[pPage * InstrsPerPage];
+
+    for (int i = 0; i < InstrsPerPage; i++)
+	instr[i].opCode = 0;
+    DropBlocks(pPage);
+}
+
 //----------------------------------------------------------------------
 // Machine::Debugger
 // 	Primitive debugger for user programs.  Note that we can't use
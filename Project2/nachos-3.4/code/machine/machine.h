@@ -26,15 +26,24 @@
 #include "translate.h"
 #include "disk.h"
 
-// Definitions related to the size, and format of user memory
-
-#define PageSize 	SectorSize 	// set the page size equal to
-					// the disk sector size, for
-					// simplicity
-
-#define NumPhysPages    32
+// Definitions related to the size, and format of user memory.  The page
+// size and the number of pages are chosen when Nachos starts (-PS and
+// -NP; see Initialize), before the machine is made.
+
+#define PageSize 	pageSize 	// by default, the disk sector size,
+					// for simplicity
+#define NumPhysPages    numPhysPages	// by default, DefaultPhysPages
+#define DefaultPhysPages 32
 #define MemorySize 	(NumPhysPages * PageSize)
+
+extern int pageSize;			// bytes per page, a multiple of 4
+extern int numPhysPages;		// pages of physical memory
 #define TLBSize		4		// if there is a TLB, make it small
+#define NumASIDs	64		// address space ids a TLB entry
+					// can be tagged with
+#define MicroTLBSize	16		// slots in the simulator's cache of
+					// page table lookups
+#define InstrsPerPage	(PageSize / 4)	// instruction words in one frame
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -91,6 +100,9 @@ class Instruction {
                      // Immediates are sign-extended.
 };
 
+class Block;		// a translated basic block; see mipsblock.h
+class Profile;		// user instruction counts; see profile.h
+
 // The following class defines the simulated host workstation hardware, as 
 // seen by user programs -- the CPU registers, main memory, etc.
 // User programs shouldn't be able to tell that they are running on our 
@@ -101,8 +113,8 @@ class Instruction {
 // If we were to implement more of the UNIX system calls, we ought to be
 // able to run Nachos on top of Nachos!
 //
-// The procedures in this class are defined in machine.cc, mipssim.cc, and
-// translate.cc.
+// The procedures in this class are defined in machine.cc, mipssim.cc,
+// mipsblock.cc, and translate.cc.
 
 class Machine {
   public:
@@ -121,6 +133,20 @@ class Machine {
 
 // Routines internal to the machine simulation -- DO NOT call these 
 
+    void RunThreaded();		// Run(), using the threaded interpreter
+				// (selected with -F); never returns
+    void RunBlocks();		// Run(), using the basic-block translator
+				// (selected with -B); never returns
+    Block *TranslateBlock(int physAddr);
+				// Build the block starting at "physAddr",
+				// or return NULL if it can't start one
+
+    Instruction *FetchInstruction();
+    				// Translate the PC and return the predecoded
+				// instruction there, or NULL on an exception
+    Instruction *DecodeAt(int physAddr);
+				// Return the predecoded instruction at 
+				// "physAddr", decoding it if need be
     void OneInstruction(Instruction *instr); 	
     				// Run one instruction of a user program.
     void DelayedLoad(int nextReg, int nextVal);  	
@@ -139,10 +165,29 @@ class Machine {
     				// and return an exception code if the 
 				// translation couldn't be completed.
 
+    void EnableTLB(int size);	// Translate through a TLB of "size"
+				// entries instead of a page table
+
+    void FlushMicroTLB();	// Forget all cached translations
+    void FlushMicroTLB(int vpn); // Forget the cached translation of one
+				// virtual page, if there is one
+
     void RaiseException(ExceptionType which, int badVAddr);
 				// Trap to the Nachos kernel, because of a
 				// system call or other exception.  
 
+    void InvalidateFrame(int pPage);
+				// Forget any predecoded instructions and
+				// translated blocks held for physical page
+				// "pPage", because its contents are about
+				// to be replaced
+    void NoteWrite(int physAddr)	// Called after every store, in case
+      { if (decodeCache[physAddr / 4].opCode != 0)	// it overwrote code
+	    CodeWritten(physAddr); }
+    void CodeWritten(int physAddr);	// Forget the stale copies of the 
+				// instruction at "physAddr"
+    void DropBlocks(int pPage);	// Free the blocks translated from "pPage"
+
     void Debugger();		// invoke the user program debugger
     void DumpState();		// print the user CPU and memory state 
 
@@ -157,6 +202,17 @@ class Machine {
 				// code and data, while executing
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
 
+    Instruction *decodeCache;	// predecoded copy of each word of
+				// mainMemory, so that a loop does not
+				// re-decode its body on every pass.  An
+				// entry with opCode 0 has not been decoded.
+    Block **blockCache;		// translated block starting at each word
+				// of mainMemory, or NULL.  A block never
+				// crosses a page, and every word it covers
+				// has a decodeCache entry.
+    Instruction **blockCode;	// a page's worth of room for the
+				// instructions of a block being translated
+
 
 // NOTE: the hardware translation of virtual addresses in the user program
 // to physical addresses (relative to the beginning of "mainMemory")
@@ -178,14 +234,27 @@ class Machine {
 
     TranslationEntry *tlb;		// this pointer should be considered 
 					// "read-only" to Nachos kernel code
+    int tlbSize;			// number of entries in "tlb"
+    int tlbAsid;			// only TLB entries tagged with this
+					// address space id are used; the
+					// kernel sets it on a context switch
+
+    MicroTLBEntry microTLB[MicroTLBSize]; // recent page table lookups,
+					// indexed by vpn % MicroTLBSize; the
+					// kernel must flush it when it
+					// changes a page table entry, or
+					// switches page tables
 
     TranslationEntry *pageTable;
     
     unsigned int pageTableSize;
+
+    Profile *profile;		// where Run() counts the instructions of
+				// the running program (-P), or NULL; set
+				// by the kernel on a context switch
     
     //start code changes by joseph kokenge
-    unsigned int twoLevelPageTableSize;
-    TranslationEntry **outerPageTable;
+    RadixTable *radixTable;	// used instead of "pageTable" with -H
     //end code changes by joseph kokenge
 
 
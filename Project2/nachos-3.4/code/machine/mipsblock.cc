@@ -0,0 +1,721 @@
+// mipsblock.cc
+//	Routines to translate MIPS basic blocks into micro-ops, and to
+//	run user programs a block at a time.  See mipsblock.h.
+//
+//	Every micro-op must have exactly the effect the same instruction
+//	has in OneInstruction() (mipssim.cc), quirks and all, so that the
+//	block translator can be swapped for the interpreter at any
+//	instruction boundary.  When changing one, change the other.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#include "machine.h"
+#include "mipssim.h"
+#include "mipsblock.h"
+#include "system.h"
+
+#define R(x)	(s->reg[x])
+
+//----------------------------------------------------------------------
+// Retire
+// 	Finish one instruction: do the delayed load that was pending
+//	(cf. Machine::DelayedLoad), and start the one it asked for, if any.
+//----------------------------------------------------------------------
+
+static inline void
+Retire(BlockState *s, int nextReg, int nextValue)
+{
+    s->reg[s->loadReg] = s->loadValue;
+    s->loadReg = nextReg;
+    s->loadValue = nextValue;
+    s->reg[0] = 0;
+}
+
+//----------------------------------------------------------------------
+// Fault
+// 	Stop the block because the instruction of "op" raised an
+//	exception.  As in OneInstruction, the instruction is abandoned
+//	without doing the delayed load; RunBlocks traps to the kernel.
+//----------------------------------------------------------------------
+
+static inline MicroOp *
+Fault(BlockState *s, MicroOp *op, ExceptionType which, int badVAddr)
+{
+    s->exception = which;
+    s->badVAddr = badVAddr;
+    s->faultIndex = op->index;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// Stored
+// 	Finish a store to "physAddr".  If it overwrote a decoded 
+//	instruction, stop the block after it: the blocks translated
+//	from that page, maybe this one too, have to be dropped, which
+//	RunBlocks does once it is done with this block.
+//----------------------------------------------------------------------
+
+static inline MicroOp *
+Stored(BlockState *s, MicroOp *op, int physAddr)
+{
+    Retire(s, 0, 0);
+    if (s->machine->decodeCache[physAddr / 4].opCode == 0)
+	return op + 1;
+    s->codeWritten = physAddr;
+    s->stopIndex = op->index + 1;
+    return NULL;
+}
+
+// Translate "addr" into "physAddr" for the current micro-op, or stop
+#define ACCESS(addr, size, writing) {					\
+	ExceptionType e = s->machine->Translate(addr, &physAddr, size,	\
+						writing);		\
+	if (e != NoException)						\
+	    return Fault(s, op, e, addr);				\
+    }
+
+// A micro-op that can't raise an exception or start a delayed load
+#define SIMPLE_OP(name, action)						\
+    static MicroOp *							\
+    name(BlockState *s, MicroOp *op)					\
+    {									\
+	action;								\
+	Retire(s, 0, 0);						\
+	return op + 1;							\
+    }
+
+// Arithmetic, logical and shift instructions.  Immediates are masked
+// or shifted as the instruction needs at translation time.
+
+SIMPLE_OP(DoADDIU, R(op->rt) = R(op->rs) + op->extra)
+SIMPLE_OP(DoADDU, R(op->rd) = R(op->rs) + R(op->rt))
+SIMPLE_OP(DoAND, R(op->rd) = R(op->rs) & R(op->rt))
+SIMPLE_OP(DoANDI, R(op->rt) = R(op->rs) & op->extra)
+SIMPLE_OP(DoLUI, R(op->rt) = op->extra)
+SIMPLE_OP(DoNOR, R(op->rd) = ~(R(op->rs) | R(op->rt)))
+SIMPLE_OP(DoOR, R(op->rd) = R(op->rs) | R(op->rs))	// sic
+SIMPLE_OP(DoORI, R(op->rt) = R(op->rs) | op->extra)
+SIMPLE_OP(DoSLL, R(op->rd) = R(op->rt) << op->extra)
+SIMPLE_OP(DoSLLV, R(op->rd) = R(op->rt) << (R(op->rs) & 0x1f))
+SIMPLE_OP(DoSLT, R(op->rd) = (R(op->rs) < R(op->rt)) ? 1 : 0)
+SIMPLE_OP(DoSLTI, R(op->rt) = (R(op->rs) < op->extra) ? 1 : 0)
+SIMPLE_OP(DoSLTIU, R(op->rt) = ((unsigned int) R(op->rs)
+				< (unsigned int) op->extra) ? 1 : 0)
+SIMPLE_OP(DoSLTU, R(op->rd) = ((unsigned int) R(op->rs)
+				< (unsigned int) R(op->rt)) ? 1 : 0)
+SIMPLE_OP(DoSRA, R(op->rd) = R(op->rt) >> op->extra)
+SIMPLE_OP(DoSRAV, R(op->rd) = R(op->rt) >> (R(op->rs) & 0x1f))
+SIMPLE_OP(DoSRL, R(op->rd) = R(op->rt) >> op->extra)	// sic -- signed,
+SIMPLE_OP(DoSRLV, R(op->rd) = R(op->rt) >> (R(op->rs) & 0x1f))	// too
+SIMPLE_OP(DoSUBU, R(op->rd) = R(op->rs) - R(op->rt))
+SIMPLE_OP(DoXOR, R(op->rd) = R(op->rs) ^ R(op->rt))
+SIMPLE_OP(DoXORI, R(op->rt) = R(op->rs) ^ op->extra)
+
+// Multiply and divide
+
+SIMPLE_OP(DoMFHI, R(op->rd) = R(HiReg))
+SIMPLE_OP(DoMFLO, R(op->rd) = R(LoReg))
+SIMPLE_OP(DoMTHI, R(HiReg) = R(op->rs))
+SIMPLE_OP(DoMTLO, R(LoReg) = R(op->rs))
+SIMPLE_OP(DoMULT, Mult(R(op->rs), R(op->rt), TRUE, &R(HiReg), &R(LoReg)))
+SIMPLE_OP(DoMULTU, Mult(R(op->rs), R(op->rt), FALSE, &R(HiReg), &R(LoReg)))
+
+static MicroOp *
+DoDIV(BlockState *s, MicroOp *op)
+{
+    if (R(op->rt) == 0) {
+	R(LoReg) = 0;
+	R(HiReg) = 0;
+    } else {
+	R(LoReg) = R(op->rs) / R(op->rt);
+	R(HiReg) = R(op->rs) % R(op->rt);
+    }
+    Retire(s, 0, 0);
+    return op + 1;
+}
+
+static MicroOp *
+DoDIVU(BlockState *s, MicroOp *op)
+{
+    unsigned int rs = (unsigned int) R(op->rs);
+    unsigned int rt = (unsigned int) R(op->rt);
+
+    if (rt == 0) {
+	R(LoReg) = 0;
+	R(HiReg) = 0;
+    } else {
+	R(LoReg) = (int) (rs / rt);
+	R(HiReg) = (int) (rs % rt);
+    }
+    Retire(s, 0, 0);
+    return op + 1;
+}
+
+// The instructions that can overflow
+
+static MicroOp *
+DoADD(BlockState *s, MicroOp *op)
+{
+    int sum = R(op->rs) + R(op->rt);
+
+    if (!((R(op->rs) ^ R(op->rt)) & SIGN_BIT)
+				&& ((R(op->rs) ^ sum) & SIGN_BIT))
+	return Fault(s, op, OverflowException, 0);
+    R(op->rd) = sum;
+    Retire(s, 0, 0);
+    return op + 1;
+}
+
+static MicroOp *
+DoADDI(BlockState *s, MicroOp *op)
+{
+    int sum = R(op->rs) + op->extra;
+
+    if (!((R(op->rs) ^ op->extra) & SIGN_BIT)
+				&& ((op->extra ^ sum) & SIGN_BIT))
+	return Fault(s, op, OverflowException, 0);
+    R(op->rt) = sum;
+    Retire(s, 0, 0);
+    return op + 1;
+}
+
+static MicroOp *
+DoSUB(BlockState *s, MicroOp *op)
+{
+    int diff = R(op->rs) - R(op->rt);
+
+    if (((R(op->rs) ^ R(op->rt)) & SIGN_BIT)
+				&& ((R(op->rs) ^ diff) & SIGN_BIT))
+	return Fault(s, op, OverflowException, 0);
+    R(op->rd) = diff;
+    Retire(s, 0, 0);
+    return op + 1;
+}
+
+// Loads and stores.  Loads only start the delayed load; the register
+// is written when the next instruction retires.
+
+static MicroOp *
+DoLB(BlockState *s, MicroOp *op)	// also LBU
+{
+    int addr = R(op->rs) + op->extra;
+    int physAddr, value;
+
+    ACCESS(addr, 1, FALSE);
+    value = s->mem[physAddr];
+    if ((value & 0x80) && (op->rd == OP_LB))	// rd holds the opcode
+	value |= 0xffffff00;
+    else
+	value &= 0xff;
+    Retire(s, op->rt, value);
+    return op + 1;
+}
+
+static MicroOp *
+DoLH(BlockState *s, MicroOp *op)	// also LHU
+{
+    int addr = R(op->rs) + op->extra;
+    int physAddr, value;
+
+    if (addr & 0x1)
+	return Fault(s, op, AddressErrorException, addr);
+    ACCESS(addr, 2, FALSE);
+    value = ShortToHost(*(unsigned short *) &s->mem[physAddr]);
+    if ((value & 0x8000) && (op->rd == OP_LH))
+	value |= 0xffff0000;
+    else
+	value &= 0xffff;
+    Retire(s, op->rt, value);
+    return op + 1;
+}
+
+static MicroOp *
+DoLW(BlockState *s, MicroOp *op)
+{
+    int addr = R(op->rs) + op->extra;
+    int physAddr;
+
+    if (addr & 0x3)
+	return Fault(s, op, AddressErrorException, addr);
+    ACCESS(addr, 4, FALSE);
+    Retire(s, op->rt, WordToHost(*(unsigned int *) &s->mem[physAddr]));
+    return op + 1;
+}
+
+static MicroOp *
+DoSB(BlockState *s, MicroOp *op)
+{
+    int addr = R(op->rs) + op->extra;
+    int physAddr;
+
+    ACCESS(addr, 1, TRUE);
+    s->mem[physAddr] = (unsigned char) (R(op->rt) & 0xff);
+    return Stored(s, op, physAddr);
+}
+
+static MicroOp *
+DoSH(BlockState *s, MicroOp *op)
+{
+    int addr = R(op->rs) + op->extra;
+    int physAddr;
+
+    ACCESS(addr, 2, TRUE);
+    *(unsigned short *) &s->mem[physAddr]
+		= ShortToMachine((unsigned short) (R(op->rt) & 0xffff));
+    return Stored(s, op, physAddr);
+}
+
+static MicroOp *
+DoSW(BlockState *s, MicroOp *op)
+{
+    int addr = R(op->rs) + op->extra;
+    int physAddr;
+
+    ACCESS(addr, 4, TRUE);
+    *(unsigned int *) &s->mem[physAddr] = WordToMachine((unsigned int) R(op->rt));
+    return Stored(s, op, physAddr);
+}
+
+// Branches and jumps.  These only record where to go in "branchTo";
+// the block ends after the delay slot, and RunBlocks moves the PC.
+// "extra" is the branch target, relative to the start of the block.
+
+#define FALL_THROUGH(op)	(((op)->index + 2) * 4)	// and delay slot
+
+SIMPLE_OP(DoBEQ, s->branchTo = s->pc
+		+ ((R(op->rs) == R(op->rt)) ? op->extra : FALL_THROUGH(op)))
+SIMPLE_OP(DoBNE, s->branchTo = s->pc
+		+ ((R(op->rs) != R(op->rt)) ? op->extra : FALL_THROUGH(op)))
+SIMPLE_OP(DoBGEZ, s->branchTo = s->pc
+		+ (!(R(op->rs) & SIGN_BIT) ? op->extra : FALL_THROUGH(op)))
+SIMPLE_OP(DoBGTZ, s->branchTo = s->pc
+		+ ((R(op->rs) > 0) ? op->extra : FALL_THROUGH(op)))
+SIMPLE_OP(DoBLEZ, s->branchTo = s->pc
+		+ ((R(op->rs) <= 0) ? op->extra : FALL_THROUGH(op)))
+SIMPLE_OP(DoBLTZ, s->branchTo = s->pc
+		+ ((R(op->rs) & SIGN_BIT) ? op->extra : FALL_THROUGH(op)))
+SIMPLE_OP(DoBGEZAL, R(R31) = s->pc + FALL_THROUGH(op);	// link first, as
+	s->branchTo = s->pc				// in OneInstruction
+		+ (!(R(op->rs) & SIGN_BIT) ? op->extra : FALL_THROUGH(op)))
+SIMPLE_OP(DoBLTZAL, R(R31) = s->pc + FALL_THROUGH(op);
+	s->branchTo = s->pc
+		+ ((R(op->rs) & SIGN_BIT) ? op->extra : FALL_THROUGH(op)))
+SIMPLE_OP(DoJ, s->branchTo = ((s->pc + FALL_THROUGH(op)) & 0xf0000000)
+		| op->extra)
+SIMPLE_OP(DoJAL, R(R31) = s->pc + FALL_THROUGH(op);
+	s->branchTo = ((s->pc + FALL_THROUGH(op)) & 0xf0000000) | op->extra)
+SIMPLE_OP(DoJALR, R(op->rd) = s->pc + FALL_THROUGH(op); 
+	s->branchTo = R(op->rs))
+SIMPLE_OP(DoJR, s->branchTo = R(op->rs))
+
+static MicroOp *
+DoSYSCALL(BlockState *s, MicroOp *op)
+{
+    return Fault(s, op, SyscallException, 0);
+}
+
+static MicroOp *
+DoEnd(BlockState *s, MicroOp *op)
+{
+    return NULL;
+}
+
+// Superinstructions.  Each does the work of two adjacent instructions,
+// retiring them one after the other; the second one never raises an
+// exception, so a fault always belongs to the first.
+
+SIMPLE_OP(DoLUI_ORI, R(op->rt) = op->extra; Retire(s, 0, 0);
+	R(op->rt2) = R(op->rs2) | op->extra2)
+SIMPLE_OP(DoLUI_ADDIU, R(op->rt) = op->extra; Retire(s, 0, 0);
+	R(op->rt2) = R(op->rs2) + op->extra2)
+SIMPLE_OP(DoADDIU_BEQ, R(op->rt) = R(op->rs) + op->extra; Retire(s, 0, 0);
+	s->branchTo = s->pc + ((R(op->rs2) == R(op->rt2)) ? op->extra2
+						: FALL_THROUGH(op) + 4))
+SIMPLE_OP(DoADDIU_BNE, R(op->rt) = R(op->rs) + op->extra; Retire(s, 0, 0);
+	s->branchTo = s->pc + ((R(op->rs2) != R(op->rt2)) ? op->extra2
+						: FALL_THROUGH(op) + 4))
+
+// A load together with the instruction in its delay slot, so the
+// loaded value never has to wait in the BlockState.
+
+static MicroOp *
+DoLW_ADDIU(BlockState *s, MicroOp *op)
+{
+    int addr = R(op->rs) + op->extra;
+    int physAddr;
+
+    if (addr & 0x3)
+	return Fault(s, op, AddressErrorException, addr);
+    ACCESS(addr, 4, FALSE);
+    Retire(s, op->rt, WordToHost(*(unsigned int *) &s->mem[physAddr]));
+    R(op->rt2) = R(op->rs2) + op->extra2;
+    Retire(s, 0, 0);
+    return op + 1;
+}
+
+static MicroOp *
+DoLW_ADDU(BlockState *s, MicroOp *op)
+{
+    int addr = R(op->rs) + op->extra;
+    int physAddr;
+
+    if (addr & 0x3)
+	return Fault(s, op, AddressErrorException, addr);
+    ACCESS(addr, 4, FALSE);
+    Retire(s, op->rt, WordToHost(*(unsigned int *) &s->mem[physAddr]));
+    R(op->rd2) = R(op->rs2) + R(op->rt2);
+    Retire(s, 0, 0);
+    return op + 1;
+}
+
+static MicroOp *
+DoLW_SLL(BlockState *s, MicroOp *op)
+{
+    int addr = R(op->rs) + op->extra;
+    int physAddr;
+
+    if (addr & 0x3)
+	return Fault(s, op, AddressErrorException, addr);
+    ACCESS(addr, 4, FALSE);
+    Retire(s, op->rt, WordToHost(*(unsigned int *) &s->mem[physAddr]));
+    R(op->rd2) = R(op->rt2) << op->extra2;
+    Retire(s, 0, 0);
+    return op + 1;
+}
+
+//----------------------------------------------------------------------
+// MicroFor
+// 	Return the micro-op routine for an opcode, or NULL if blocks
+//	can't contain it (it is left to the interpreter).
+//----------------------------------------------------------------------
+
+static MicroFunc
+MicroFor(int opCode)
+{
+    switch (opCode) {
+      case OP_ADD:	return DoADD;
+      case OP_ADDI:	return DoADDI;
+      case OP_ADDIU:	return DoADDIU;
+      case OP_ADDU:	return DoADDU;
+      case OP_AND:	return DoAND;
+      case OP_ANDI:	return DoANDI;
+      case OP_BEQ:	return DoBEQ;
+      case OP_BGEZ:	return DoBGEZ;
+      case OP_BGEZAL:	return DoBGEZAL;
+      case OP_BGTZ:	return DoBGTZ;
+      case OP_BLEZ:	return DoBLEZ;
+      case OP_BLTZ:	return DoBLTZ;
+      case OP_BLTZAL:	return DoBLTZAL;
+      case OP_BNE:	return DoBNE;
+      case OP_DIV:	return DoDIV;
+      case OP_DIVU:	return DoDIVU;
+      case OP_J:	return DoJ;
+      case OP_JAL:	return DoJAL;
+      case OP_JALR:	return DoJALR;
+      case OP_JR:	return DoJR;
+      case OP_LB:
+      case OP_LBU:	return DoLB;
+      case OP_LH:
+      case OP_LHU:	return DoLH;
+      case OP_LUI:	return DoLUI;
+      case OP_LW:	return DoLW;
+      case OP_MFHI:	return DoMFHI;
+      case OP_MFLO:	return DoMFLO;
+      case OP_MTHI:	return DoMTHI;
+      case OP_MTLO:	return DoMTLO;
+      case OP_MULT:	return DoMULT;
+      case OP_MULTU:	return DoMULTU;
+      case OP_NOR:	return DoNOR;
+      case OP_OR:	return DoOR;
+      case OP_ORI:	return DoORI;
+      case OP_SB:	return DoSB;
+      case OP_SH:	return DoSH;
+      case OP_SLL:	return DoSLL;
+      case OP_SLLV:	return DoSLLV;
+      case OP_SLT:	return DoSLT;
+      case OP_SLTI:	return DoSLTI;
+      case OP_SLTIU:	return DoSLTIU;
+      case OP_SLTU:	return DoSLTU;
+      case OP_SRA:	return DoSRA;
+      case OP_SRAV:	return DoSRAV;
+      case OP_SRL:	return DoSRL;
+      case OP_SRLV:	return DoSRLV;
+      case OP_SUB:	return DoSUB;
+      case OP_SUBU:	return DoSUBU;
+      case OP_SW:	return DoSW;
+      case OP_SYSCALL:	return DoSYSCALL;
+      case OP_XOR:	return DoXOR;
+      case OP_XORI:	return DoXORI;
+      default:		return NULL;	// LWL, LWR, SWL, SWR, and
+    }					// illegal instructions
+}
+
+//----------------------------------------------------------------------
+// IsControl
+// 	Return TRUE if the instruction changes the flow of control, and
+//	so ends a block (after its delay slot).
+//----------------------------------------------------------------------
+
+static bool
+IsControl(int opCode)
+{
+    switch (opCode) {
+      case OP_BEQ: case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+      case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL: case OP_BNE:
+      case OP_J: case OP_JAL: case OP_JALR: case OP_JR:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Block::Block, Block::~Block
+// 	Allocate or free a block of "len" instructions, translated into
+//	"numOps" micro-ops (plus the one that ends the block).
+//----------------------------------------------------------------------
+
+Block::Block(int len, int numOps)
+{
+    length = len;
+    branchAt = -1;
+    ops = new MicroOp[numOps + 1];
+    ops[numOps].exec = DoEnd;
+}
+
+Block::~Block()
+{
+    delete [] ops;
+}
+
+//----------------------------------------------------------------------
+// Machine::TranslateBlock
+// 	Translate the basic block starting at a physical address, and
+//	enter it in blockCache.  The block runs to the first branch or
+//	jump and its delay slot, a system call, an instruction the
+//	translator doesn't handle, or the end of the page, whichever
+//	comes first.
+//
+//	Returns NULL if the very first instruction can't be translated.
+//
+//	"physAddr" -- where the block starts in mainMemory
+//----------------------------------------------------------------------
+
+Block *
+Machine::TranslateBlock(int physAddr)
+{
+    Instruction **code = blockCode;
+    int pageEnd = (physAddr / PageSize + 1) * PageSize;
+    int len = 0, branchAt = -1;
+    int i, n;
+
+    for (int addr = physAddr; addr < pageEnd; addr += 4) {
+	Instruction *instr = DecodeAt(addr);
+
+	if (MicroFor(instr->opCode) == NULL)
+	    break;
+	if (branchAt >= 0 && IsControl(instr->opCode))
+	    break;			// branch in a delay slot: leave it
+	code[len++] = instr;		// to the interpreter
+	if (branchAt >= 0 || instr->opCode == OP_SYSCALL)
+	    break;
+	if (IsControl(instr->opCode))
+	    branchAt = len - 1;
+    }
+    if (len == 0)
+	return NULL;
+
+    Block *block = new Block(len, len);	// at most one op per instruction
+    block->branchAt = branchAt;
+    for (i = 0, n = 0; i < len; i++, n++) {
+	Instruction *instr = code[i];
+	Instruction *next = (i + 1 < len) ? code[i + 1] : NULL;
+	MicroOp *op = &block->ops[n];
+
+	op->exec = MicroFor(instr->opCode);
+	op->index = i;
+	op->rs = instr->rs;
+	op->rt = instr->rt;
+	op->rd = instr->rd;
+	op->extra = instr->extra;
+	switch (instr->opCode) {	// operands in the form the routine
+	  case OP_ANDI:			// wants them
+	  case OP_ORI:
+	  case OP_XORI:
+	    op->extra = instr->extra & 0xffff;
+	    break;
+	  case OP_LUI:
+	    op->extra = instr->extra << 16;
+	    break;
+	  case OP_LB: case OP_LBU: case OP_LH: case OP_LHU:
+	    op->rd = instr->opCode;	// to tell the signed ones apart
+	    break;
+	  case OP_J:
+	  case OP_JAL:
+	    op->extra = IndexToAddr(instr->extra);
+	    break;
+	  case OP_BEQ: case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+	  case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL: case OP_BNE:
+	    op->extra = (i + 1) * 4 + IndexToAddr(instr->extra);
+	    break;
+	}
+	if (next == NULL)
+	    continue;
+
+	// Look for a pair to fuse into a superinstruction
+	op->rs2 = next->rs;
+	op->rt2 = next->rt;
+	op->rd2 = next->rd;
+	op->extra2 = next->extra;
+	if (instr->opCode == OP_LUI && next->opCode == OP_ORI) {
+	    op->exec = DoLUI_ORI;
+	    op->extra2 = next->extra & 0xffff;
+	} else if (instr->opCode == OP_LUI && next->opCode == OP_ADDIU) {
+	    op->exec = DoLUI_ADDIU;
+	} else if (instr->opCode == OP_LW && next->opCode == OP_ADDIU) {
+	    op->exec = DoLW_ADDIU;
+	} else if (instr->opCode == OP_LW && next->opCode == OP_ADDU) {
+	    op->exec = DoLW_ADDU;
+	} else if (instr->opCode == OP_LW && next->opCode == OP_SLL) {
+	    op->exec = DoLW_SLL;
+	} else if (instr->opCode == OP_ADDIU
+		   && (next->opCode == OP_BEQ || next->opCode == OP_BNE)) {
+	    op->exec = (next->opCode == OP_BEQ) ? DoADDIU_BEQ : DoADDIU_BNE;
+	    op->extra2 = (i + 2) * 4 + IndexToAddr(next->extra);
+	} else {
+	    continue;			// nothing to fuse
+	}
+	i++;				// the pair takes one op
+    }
+    block->ops[n].exec = DoEnd;
+    blockCache[physAddr / 4] = block;
+    return block;
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlocks
+// 	Same job as Run(), but a basic block at a time.  Selected with
+//	-B; Run() falls back to the reference loop when single-stepping
+//	or tracing.
+//
+//	Simulated time still advances one tick per instruction.  A block
+//	is only run if no interrupt can come due before it finishes, in
+//	which case its ticks are added in one go; otherwise (and for the
+//	instructions the translator leaves alone, or when the PC is in
+//	a delay slot) we interpret one instruction, just like Run().
+//----------------------------------------------------------------------
+
+void
+Machine::RunBlocks()
+{
+    BlockState s;
+    ExceptionType exception;
+    Block *block;
+    MicroOp *op;
+    int pc, physAddr, done;
+
+    s.machine = this;
+    s.reg = registers;
+    s.mem = mainMemory;
+    for (;;) {
+	pc = registers[PCReg];
+	exception = Translate(pc, &physAddr, 4, FALSE);
+	if (exception != NoException) {
+	    RaiseException(exception, pc);
+	    ONE_USER_TICK();
+	    continue;
+	}
+	block = NULL;
+	if (registers[NextPCReg] == pc + 4) {
+	    block = blockCache[physAddr / 4];
+	    if (block == NULL)
+		block = TranslateBlock(physAddr);
+	}
+	if (block == NULL
+		|| stats->totalTicks + block->length * UserTick
+						>= interrupt->NextDue()) {
+	    OneInstruction(DecodeAt(physAddr));
+	    ONE_USER_TICK();
+	    continue;
+	}
+
+	s.pc = pc;
+	s.loadReg = registers[LoadReg];
+	s.loadValue = registers[LoadValueReg];
+	s.exception = NoException;
+	s.codeWritten = -1;
+	op = block->ops;
+	while ((op = (*op->exec)(&s, op)) != NULL)
+	    ;
+
+	if (s.exception != NoException)
+	    done = s.faultIndex;	// instructions before the fault
+	else if (s.codeWritten != -1)
+	    done = s.stopIndex;		// up to the store
+	else
+	    done = block->length;
+
+	if (done > 0)
+	    registers[PrevPCReg] = pc + (done - 1) * 4;
+	if (done > 0 && done - 1 == block->branchAt) {	// no delay slot
+	    registers[PCReg] = pc + done * 4;
+	    registers[NextPCReg] = s.branchTo;
+	} else if (done > 1 && done - 2 == block->branchAt) {
+	    registers[PCReg] = s.branchTo;
+	    registers[NextPCReg] = s.branchTo + 4;
+	} else {
+	    registers[PCReg] = pc + done * 4;
+	    registers[NextPCReg] = pc + done * 4 + 4;
+	}
+	registers[LoadReg] = s.loadReg;
+	registers[LoadValueReg] = s.loadValue;
+	stats->totalTicks += done * UserTick;
+	stats->userTicks += done * UserTick;
+	if (s.codeWritten != -1)	// "block" may be gone after this
+	    CodeWritten(s.codeWritten);
+
+	if (s.exception != NoException) {	// the faulting instruction
+	    RaiseException(s.exception, s.badVAddr);	// gets the usual
+	    ONE_USER_TICK();				// tick
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::CodeWritten
+// 	A store has just overwritten an instruction that was decoded, so
+//	forget it, and any block that might contain it.
+//
+//	"physAddr" -- the address stored to
+//----------------------------------------------------------------------
+
+void
+Machine::CodeWritten(int physAddr)
+{
+    decodeCache[physAddr / 4].opCode = 0;
+    DropBlocks(physAddr / PageSize);
+}
+
+//----------------------------------------------------------------------
+// Machine::DropBlocks
+// 	Free all the blocks translated from one physical page.
+//
+//	"pPage" -- the physical page
+//----------------------------------------------------------------------
+
+void
+Machine::DropBlocks(int pPage)
+{
+    Block **entry = &blockCache[pPage * InstrsPerPage];
+
+    for (int i = 0; i < InstrsPerPage; i++) {
+	if (entry[i] != NULL) {
+	    delete entry[i];
+	    entry[i] = NULL;
+	}
+    }
+}
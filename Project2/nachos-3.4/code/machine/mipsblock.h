@@ -0,0 +1,84 @@
+// mipsblock.h
+//	Data structures for the basic-block translator, an alternative
+//	to interpreting user programs one instruction at a time.
+//
+//	A straight-line run of MIPS instructions -- up to and including
+//	the first branch or jump and its delay slot, or a system call --
+//	is translated once into an array of "micro-ops".  Each micro-op
+//	is a host routine plus the operands it needs, already pulled out
+//	of the instruction; running the block is then just a matter of
+//	calling each routine in turn.  Common pairs of instructions are
+//	translated into a single micro-op (a "superinstruction").
+//
+//	Blocks are cached by the physical address of their first
+//	instruction (Machine::blockCache), never cross a page, and are
+//	thrown away along with the predecoded instructions whenever the
+//	frame is refilled or one of its instruction words is stored to.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef MIPSBLOCK_H
+#define MIPSBLOCK_H
+
+#include "copyright.h"
+#include "machine.h"
+
+class BlockState;
+class MicroOp;
+
+// A micro-op routine returns the next micro-op to run, or NULL if
+// the block is over (either normally, or because of an exception,
+// in which case it fills in the details in the BlockState).
+
+typedef MicroOp *(*MicroFunc)(BlockState *s, MicroOp *op);
+
+// One step of a translated block.
+
+class MicroOp {
+  public:
+    MicroFunc exec;		// host routine to carry out the step
+    int index;			// position in the block of the (first)
+				// instruction it covers
+    unsigned char rs, rt, rd;	// register operands
+    int extra;			// immediate, shift amount, or branch
+				// target relative to the block start
+    unsigned char rs2, rt2, rd2; // operands of the second instruction
+    int extra2;			// of a superinstruction
+};
+
+// A translated basic block.
+
+class Block {
+  public:
+    Block(int len, int numOps);
+    ~Block();
+
+    int length;			// number of MIPS instructions covered
+    int branchAt;		// index of its branch or jump, -1 if none
+    MicroOp *ops;		// the micro-ops, ending with one whose
+				// routine always returns NULL
+};
+
+// Simulated CPU state while a block is running.  The rest of the
+// machine state is accessed through "machine" as usual.
+
+class BlockState {
+  public:
+    Machine *machine;
+    int *reg;			// == machine->registers
+    char *mem;			// == machine->mainMemory
+    int pc;			// address of the block's first instruction
+    int branchTo;		// where the block's branch or jump goes
+    int loadReg, loadValue;	// delayed load in progress
+
+    ExceptionType exception;	// why the block stopped early, if it did
+    int badVAddr;		// the address that caused the exception
+    int faultIndex;		// which instruction caused it
+    int codeWritten;		// where a store overwrote a decoded
+				// instruction, stopping the block, or -1
+    int stopIndex;		// instructions run, up to that store
+};
+
+#endif // MIPSBLOCK_H
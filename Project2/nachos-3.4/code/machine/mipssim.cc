@@ -15,8 +15,7 @@
 #include "machine.h"
 #include "mipssim.h"
 #include "system.h"
-
-static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
+#include "profile.h"
 
 //----------------------------------------------------------------------
 // Machine::Run
@@ -30,20 +29,497 @@ static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 void
 Machine::Run()
 {
-    Instruction *instr = new Instruction;  // storage for decoded instruction
+    Instruction *instr;		// predecoded instruction at the PC
 
     if(DebugIsEnabled('m'))
         printf("Starting thread \"%s\" at time %d\n",
 	       currentThread->getName(), stats->totalTicks);
     interrupt->setStatus(UserMode);
+    if (simChoice == 1 && !singleStep && !DebugIsEnabled('m')
+				&& !DebugIsEnabled('a') && profile == NULL)
+	RunThreaded();
+    else if (simChoice == 2 && !singleStep && !DebugIsEnabled('m')
+				&& !DebugIsEnabled('a') && profile == NULL)
+	RunBlocks();
     for (;;) {
-        OneInstruction(instr);
-	interrupt->OneTick();
+	if ((instr = FetchInstruction()) != NULL) {
+	    if (profile != NULL)
+		profile->Count(instr, registers);
+	    OneInstruction(instr);
+	}
+	ONE_USER_TICK();
 	if (singleStep && (runUntilTime <= stats->totalTicks))
 	  Debugger();
     }
 }
 
+//----------------------------------------------------------------------
+// Machine::RunThreaded
+// 	Same job as Run(), but with the per-instruction overhead squeezed
+//	out, for long-running user programs.  Selected with -F; Run() 
+//	falls back to the reference loop when single-stepping or tracing.
+//
+//	Each opcode has its own handler label, and every handler ends by
+//	jumping straight to the handler of the next instruction through
+//	a label table (GCC's computed goto), instead of returning to a
+//	central switch.  The PC, next PC, previous PC and the pending 
+//	delayed load are kept in host locals; "registers" only has to be
+//	up to date when the kernel can look at it, so they are written 
+//	back (SAVE_STATE) before an exception or an interrupt, and re-read
+//	(LOAD_STATE) afterwards, since either may switch threads.
+//
+//	Results must be bit-for-bit identical to OneInstruction(), quirks
+//	and all; when changing one, change the other.
+//----------------------------------------------------------------------
+
+#define SAVE_STATE() {						\
+	registers[PCReg] = pc;					\
+	registers[NextPCReg] = nextPC;				\
+	registers[PrevPCReg] = prevPC;				\
+	registers[LoadReg] = loadReg;				\
+	registers[LoadValueReg] = loadValue;			\
+    }
+#define LOAD_STATE() {						\
+	pc = registers[PCReg];					\
+	nextPC = registers[NextPCReg];				\
+	prevPC = registers[PrevPCReg];				\
+	loadReg = registers[LoadReg];				\
+	loadValue = registers[LoadValueReg];			\
+    }
+
+// Trap to the kernel; the instruction is abandoned, as in OneInstruction
+#define TRAP(which, badVAddr) {					\
+	SAVE_STATE();						\
+	RaiseException(which, badVAddr);			\
+	goto trapped;						\
+    }
+
+// Translate "addr" for the current instruction, or trap
+#define XLATE(addr, size, writing) {				\
+	exception = Translate(addr, &physAddr, size, writing);	\
+	if (exception != NoException)				\
+	    TRAP(exception, addr);				\
+    }
+
+#define RS	registers[instr->rs]
+#define RT	registers[instr->rt]
+#define RD	registers[instr->rd]
+#define NEXT	goto retire
+
+void
+Machine::RunThreaded()
+{
+    static void *dispatch[MaxOpcode + 1];
+    static bool dispatchReady = FALSE;
+    int pc, nextPC, prevPC, loadReg, loadValue;	// hot registers
+    int nextLoadReg, nextLoadValue, pcAfter;
+    int physAddr, sum, diff, tmp, value;
+    unsigned int rs, rt, imm;
+    ExceptionType exception;
+    Instruction *instr;
+
+    if (!dispatchReady) {
+	for (int i = 0; i <= MaxOpcode; i++)
+	    dispatch[i] = &&op_BAD;
+	dispatch[OP_ADD] = &&op_ADD;	dispatch[OP_ADDI] = &&op_ADDI;
+	dispatch[OP_ADDIU] = &&op_ADDIU; dispatch[OP_ADDU] = &&op_ADDU;
+	dispatch[OP_AND] = &&op_AND;	dispatch[OP_ANDI] = &&op_ANDI;
+	dispatch[OP_BEQ] = &&op_BEQ;	dispatch[OP_BGEZ] = &&op_BGEZ;
+	dispatch[OP_BGEZAL] = &&op_BGEZAL; dispatch[OP_BGTZ] = &&op_BGTZ;
+	dispatch[OP_BLEZ] = &&op_BLEZ;	dispatch[OP_BLTZ] = &&op_BLTZ;
+	dispatch[OP_BLTZAL] = &&op_BLTZAL; dispatch[OP_BNE] = &&op_BNE;
+	dispatch[OP_DIV] = &&op_DIV;	dispatch[OP_DIVU] = &&op_DIVU;
+	dispatch[OP_J] = &&op_J;	dispatch[OP_JAL] = &&op_JAL;
+	dispatch[OP_JALR] = &&op_JALR;	dispatch[OP_JR] = &&op_JR;
+	dispatch[OP_LB] = &&op_LB;	dispatch[OP_LBU] = &&op_LB;
+	dispatch[OP_LH] = &&op_LH;	dispatch[OP_LHU] = &&op_LH;
+	dispatch[OP_LUI] = &&op_LUI;	dispatch[OP_LW] = &&op_LW;
+	dispatch[OP_LWL] = &&op_LWL;	dispatch[OP_LWR] = &&op_LWR;
+	dispatch[OP_MFHI] = &&op_MFHI;	dispatch[OP_MFLO] = &&op_MFLO;
+	dispatch[OP_MTHI] = &&op_MTHI;	dispatch[OP_MTLO] = &&op_MTLO;
+	dispatch[OP_MULT] = &&op_MULT;	dispatch[OP_MULTU] = &&op_MULTU;
+	dispatch[OP_NOR] = &&op_NOR;	dispatch[OP_OR] = &&op_OR;
+	dispatch[OP_ORI] = &&op_ORI;	dispatch[OP_SB] = &&op_SB;
+	dispatch[OP_SH] = &&op_SH;	dispatch[OP_SLL] = &&op_SLL;
+	dispatch[OP_SLLV] = &&op_SLLV;	dispatch[OP_SLT] = &&op_SLT;
+	dispatch[OP_SLTI] = &&op_SLTI;	dispatch[OP_SLTIU] = &&op_SLTIU;
+	dispatch[OP_SLTU] = &&op_SLTU;	dispatch[OP_SRA] = &&op_SRA;
+	dispatch[OP_SRAV] = &&op_SRAV;	dispatch[OP_SRL] = &&op_SRL;
+	dispatch[OP_SRLV] = &&op_SRLV;	dispatch[OP_SUB] = &&op_SUB;
+	dispatch[OP_SUBU] = &&op_SUBU;	dispatch[OP_SW] = &&op_SW;
+	dispatch[OP_SWL] = &&op_SWL;	dispatch[OP_SWR] = &&op_SWR;
+	dispatch[OP_SYSCALL] = &&op_SYSCALL;
+	dispatch[OP_XOR] = &&op_XOR;	dispatch[OP_XORI] = &&op_XORI;
+	dispatch[OP_RES] = &&op_ILLEGAL; dispatch[OP_UNIMP] = &&op_ILLEGAL;
+	dispatchReady = TRUE;
+    }
+
+    LOAD_STATE();
+
+  fetch:
+    XLATE(pc, 4, FALSE);
+    instr = &decodeCache[physAddr / 4];
+    if (instr->opCode == 0) {
+	instr->value = WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+	instr->Decode();
+    }
+    pcAfter = nextPC + 4;
+    nextLoadReg = 0;
+    nextLoadValue = 0;
+    goto *dispatch[instr->opCode];
+
+  op_ADD:
+    sum = RS + RT;
+    if (!((RS ^ RT) & SIGN_BIT) && ((RS ^ sum) & SIGN_BIT))
+	TRAP(OverflowException, 0);
+    RD = sum;
+    NEXT;
+  op_ADDI:
+    sum = RS + instr->extra;
+    if (!((RS ^ instr->extra) & SIGN_BIT) && ((instr->extra ^ sum) & SIGN_BIT))
+	TRAP(OverflowException, 0);
+    RT = sum;
+    NEXT;
+  op_ADDIU:
+    RT = RS + instr->extra;
+    NEXT;
+  op_ADDU:
+    RD = RS + RT;
+    NEXT;
+  op_AND:
+    RD = RS & RT;
+    NEXT;
+  op_ANDI:
+    RT = RS & (instr->extra & 0xffff);
+    NEXT;
+  op_BEQ:
+    if (RS == RT)
+	pcAfter = nextPC + IndexToAddr(instr->extra);
+    NEXT;
+  op_BGEZAL:
+    registers[R31] = nextPC + 4;
+  op_BGEZ:
+    if (!(RS & SIGN_BIT))
+	pcAfter = nextPC + IndexToAddr(instr->extra);
+    NEXT;
+  op_BGTZ:
+    if (RS > 0)
+	pcAfter = nextPC + IndexToAddr(instr->extra);
+    NEXT;
+  op_BLEZ:
+    if (RS <= 0)
+	pcAfter = nextPC + IndexToAddr(instr->extra);
+    NEXT;
+  op_BLTZAL:
+    registers[R31] = nextPC + 4;
+  op_BLTZ:
+    if (RS & SIGN_BIT)
+	pcAfter = nextPC + IndexToAddr(instr->extra);
+    NEXT;
+  op_BNE:
+    if (RS != RT)
+	pcAfter = nextPC + IndexToAddr(instr->extra);
+    NEXT;
+  op_DIV:
+    if (RT == 0) {
+	registers[LoReg] = 0;
+	registers[HiReg] = 0;
+    } else {
+	registers[LoReg] = RS / RT;
+	registers[HiReg] = RS % RT;
+    }
+    NEXT;
+  op_DIVU:
+    rs = (unsigned int) RS;
+    rt = (unsigned int) RT;
+    if (rt == 0) {
+	registers[LoReg] = 0;
+	registers[HiReg] = 0;
+    } else {
+	tmp = rs / rt;
+	registers[LoReg] = (int) tmp;
+	tmp = rs % rt;
+	registers[HiReg] = (int) tmp;
+    }
+    NEXT;
+  op_JAL:
+    registers[R31] = nextPC + 4;
+  op_J:
+    pcAfter = (pcAfter & 0xf0000000) | IndexToAddr(instr->extra);
+    NEXT;
+  op_JALR:
+    RD = nextPC + 4;
+  op_JR:
+    pcAfter = RS;
+    NEXT;
+  op_LB:				// LB and LBU
+    tmp = RS + instr->extra;
+    XLATE(tmp, 1, FALSE);
+    value = mainMemory[physAddr];
+    if ((value & 0x80) && (instr->opCode == OP_LB))
+	value |= 0xffffff00;
+    else
+	value &= 0xff;
+    nextLoadReg = instr->rt;
+    nextLoadValue = value;
+    NEXT;
+  op_LH:				// LH and LHU
+    tmp = RS + instr->extra;
+    if (tmp & 0x1)
+	TRAP(AddressErrorException, tmp);
+    XLATE(tmp, 2, FALSE);
+    value = ShortToHost(*(unsigned short *) &mainMemory[physAddr]);
+    if ((value & 0x8000) && (instr->opCode == OP_LH))
+	value |= 0xffff0000;
+    else
+	value &= 0xffff;
+    nextLoadReg = instr->rt;
+    nextLoadValue = value;
+    NEXT;
+  op_LUI:
+    RT = instr->extra << 16;
+    NEXT;
+  op_LW:
+    tmp = RS + instr->extra;
+    if (tmp & 0x3)
+	TRAP(AddressErrorException, tmp);
+    XLATE(tmp, 4, FALSE);
+    nextLoadReg = instr->rt;
+    nextLoadValue = WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+    NEXT;
+  op_LWL:
+    tmp = RS + instr->extra;
+    ASSERT((tmp & 0x3) == 0);  
+    XLATE(tmp, 4, FALSE);
+    value = WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+    if (loadReg == instr->rt)
+	nextLoadValue = loadValue;
+    else
+	nextLoadValue = RT;
+    switch (tmp & 0x3) {
+      case 0:
+	nextLoadValue = value;
+	break;
+      case 1:
+	nextLoadValue = (nextLoadValue & 0xff) | (value << 8);
+	break;
+      case 2:
+	nextLoadValue = (nextLoadValue & 0xffff) | (value << 16);
+	break;
+      case 3:
+	nextLoadValue = (nextLoadValue & 0xffffff) | (value << 24);
+	break;
+    }
+    nextLoadReg = instr->rt;
+    NEXT;
+  op_LWR:
+    tmp = RS + instr->extra;
+    ASSERT((tmp & 0x3) == 0);  
+    XLATE(tmp, 4, FALSE);
+    value = WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+    if (loadReg == instr->rt)
+	nextLoadValue = loadValue;
+    else
+	nextLoadValue = RT;
+    switch (tmp & 0x3) {
+      case 0:
+	nextLoadValue = (nextLoadValue & 0xffffff00) | ((value >> 24) & 0xff);
+	break;
+      case 1:
+	nextLoadValue = (nextLoadValue & 0xffff0000) | ((value >> 16) & 0xffff);
+	break;
+      case 2:
+	nextLoadValue = (nextLoadValue & 0xff000000) | ((value >> 8) & 0xffffff);
+	break;
+      case 3:
+	nextLoadValue = value;
+	break;
+    }
+    nextLoadReg = instr->rt;
+    NEXT;
+  op_MFHI:
+    RD = registers[HiReg];
+    NEXT;
+  op_MFLO:
+    RD = registers[LoReg];
+    NEXT;
+  op_MTHI:
+    registers[HiReg] = RS;
+    NEXT;
+  op_MTLO:
+    registers[LoReg] = RS;
+    NEXT;
+  op_MULT:
+    Mult(RS, RT, TRUE, &registers[HiReg], &registers[LoReg]);
+    NEXT;
+  op_MULTU:
+    Mult(RS, RT, FALSE, &registers[HiReg], &registers[LoReg]);
+    NEXT;
+  op_NOR:
+    RD = ~(RS | RT);
+    NEXT;
+  op_OR:
+    RD = RS | RS;			// sic -- matches OneInstruction
+    NEXT;
+  op_ORI:
+    RT = RS | (instr->extra & 0xffff);
+    NEXT;
+  op_SB:
+    tmp = (unsigned) (RS + instr->extra);
+    XLATE(tmp, 1, TRUE);
+    mainMemory[physAddr] = (unsigned char) (RT & 0xff);
+    NoteWrite(physAddr);
+    NEXT;
+  op_SH:
+    tmp = (unsigned) (RS + instr->extra);
+    XLATE(tmp, 2, TRUE);
+    *(unsigned short *) &mainMemory[physAddr]
+		= ShortToMachine((unsigned short) (RT & 0xffff));
+    NoteWrite(physAddr);
+    NEXT;
+  op_SLL:
+    RD = RT << instr->extra;
+    NEXT;
+  op_SLLV:
+    RD = RT << (RS & 0x1f);
+    NEXT;
+  op_SLT:
+    RD = (RS < RT) ? 1 : 0;
+    NEXT;
+  op_SLTI:
+    RT = (RS < instr->extra) ? 1 : 0;
+    NEXT;
+  op_SLTIU:
+    rs = RS;
+    imm = instr->extra;
+    RT = (rs < imm) ? 1 : 0;
+    NEXT;
+  op_SLTU:
+    rs = RS;
+    rt = RT;
+    RD = (rs < rt) ? 1 : 0;
+    NEXT;
+  op_SRA:
+    RD = RT >> instr->extra;
+    NEXT;
+  op_SRAV:
+    RD = RT >> (RS & 0x1f);
+    NEXT;
+  op_SRL:
+    tmp = RT;
+    tmp >>= instr->extra;
+    RD = tmp;
+    NEXT;
+  op_SRLV:
+    tmp = RT;
+    tmp >>= (RS & 0x1f);
+    RD = tmp;
+    NEXT;
+  op_SUB:
+    diff = RS - RT;
+    if (((RS ^ RT) & SIGN_BIT) && ((RS ^ diff) & SIGN_BIT))
+	TRAP(OverflowException, 0);
+    RD = diff;
+    NEXT;
+  op_SUBU:
+    RD = RS - RT;
+    NEXT;
+  op_SW:
+    tmp = (unsigned) (RS + instr->extra);
+    XLATE(tmp, 4, TRUE);
+    *(unsigned int *) &mainMemory[physAddr] = WordToMachine((unsigned int) RT);
+    NoteWrite(physAddr);
+    NEXT;
+  op_SWL:
+    tmp = RS + instr->extra;
+    ASSERT((tmp & 0x3) == 0);  
+    XLATE(tmp & ~0x3, 4, FALSE);
+    value = WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+    switch (tmp & 0x3) {
+      case 0:
+	value = RT;
+	break;
+      case 1:
+	value = (value & 0xff000000) | ((RT >> 8) & 0xffffff);
+	break;
+      case 2:
+	value = (value & 0xffff0000) | ((RT >> 16) & 0xffff);
+	break;
+      case 3:
+	value = (value & 0xffffff00) | ((RT >> 24) & 0xff);
+	break;
+    }
+    XLATE(tmp & ~0x3, 4, TRUE);
+    *(unsigned int *) &mainMemory[physAddr] = WordToMachine((unsigned int) value);
+    NoteWrite(physAddr);
+    NEXT;
+  op_SWR:
+    tmp = RS + instr->extra;
+    ASSERT((tmp & 0x3) == 0);  
+    XLATE(tmp & ~0x3, 4, FALSE);
+    value = WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+    switch (tmp & 0x3) {
+      case 0:
+	value = (value & 0xffffff) | (RT << 24);
+	break;
+      case 1:
+	value = (value & 0xffff) | (RT << 16);
+	break;
+      case 2:
+	value = (value & 0xff) | (RT << 8);
+	break;
+      case 3:
+	value = RT;
+	break;
+    }
+    XLATE(tmp & ~0x3, 4, TRUE);
+    *(unsigned int *) &mainMemory[physAddr] = WordToMachine((unsigned int) value);
+    NoteWrite(physAddr);
+    NEXT;
+  op_SYSCALL:
+    TRAP(SyscallException, 0);
+  op_XOR:
+    RD = RS ^ RT;
+    NEXT;
+  op_XORI:
+    RT = RS ^ (instr->extra & 0xffff);
+    NEXT;
+  op_ILLEGAL:
+    TRAP(IllegalInstrException, 0);
+  op_BAD:
+    ASSERT(FALSE);
+
+  retire:
+    // Do any delayed load operation, then advance the program counters.
+    registers[loadReg] = loadValue;
+    loadReg = nextLoadReg;
+    loadValue = nextLoadValue;
+    registers[0] = 0;
+    prevPC = pc;
+    pc = nextPC;
+    nextPC = pcAfter;
+    if (stats->totalTicks + UserTick < interrupt->NextDue()) {
+	stats->totalTicks += UserTick;	// no interrupt this tick, so 
+	stats->userTicks += UserTick;	// the registers can stay put
+	goto fetch;
+    }
+
+    SAVE_STATE();
+  trapped:
+    ONE_USER_TICK();
+    LOAD_STATE();
+    goto fetch;
+}
+
+#undef SAVE_STATE
+#undef LOAD_STATE
+#undef TRAP
+#undef XLATE
+#undef RS
+#undef RT
+#undef RD
+#undef NEXT
+
 
 //----------------------------------------------------------------------
 // TypeToReg
@@ -67,9 +543,57 @@ TypeToReg(RegType reg, Instruction *instr)
     }
 }
 
+//----------------------------------------------------------------------
+// Machine::FetchInstruction
+// 	Fetch the instruction at the PC, in decoded form.
+//
+//	Decoding is done at most once per instruction word: the result is
+//	kept in decodeCache, indexed by physical address, until the frame
+//	is reloaded (InvalidateFrame) or the word is stored to (WriteMem).
+//	The PC is still translated every time, so page faults and the
+//	use bits behave exactly as if the word had been read with ReadMem.
+//
+//	Returns NULL if the translation raised an exception.
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::FetchInstruction()
+{
+    int physAddr;
+    ExceptionType exception;
+
+    exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+    if (exception != NoException) {
+	RaiseException(exception, registers[PCReg]);
+	return NULL;
+    }
+    return DecodeAt(physAddr);
+}
+
+//----------------------------------------------------------------------
+// Machine::DecodeAt
+// 	Return the predecoded form of the instruction at a physical
+//	address, decoding it if this is the first time through here.
+//
+//	"physAddr" -- word-aligned address in mainMemory
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::DecodeAt(int physAddr)
+{
+    Instruction *instr = &decodeCache[physAddr / 4];
+
+    if (instr->opCode == 0) {
+	instr->value = WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+	instr->Decode();
+    }
+    return instr;
+}
+
 //----------------------------------------------------------------------
 // Machine::OneInstruction
-// 	Execute one instruction from a user-level program
+// 	Execute one (already fetched and decoded) instruction from a 
+//	user-level program
 //
 // 	If there is any kind of exception or interrupt, we invoke the 
 //	exception handler, and when it returns, we return to Run(), which
@@ -93,17 +617,10 @@ TypeToReg(RegType reg, Instruction *instr)
 void
 Machine::OneInstruction(Instruction *instr)
 {
-    int raw;
     int nextLoadReg = 0; 	
     int nextLoadValue = 0; 	// record delayed load operation, to apply
 				// in the future
 
-    // Fetch instruction 
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
-	return;			// exception occurred
-    instr->value = raw;
-    instr->Decode();
-
     if (DebugIsEnabled('m')) {
        struct OpString *str = &opStrings[instr->opCode];
 
@@ -632,7 +1149,7 @@ Instruction::Decode()
 // 	double-length result of the multiplication.
 //----------------------------------------------------------------------
 
-static void
+void
 Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr)
 {
     if ((a == 0) || (b == 0)) {
@@ -96,6 +96,10 @@
 #define SIGN_BIT	0x80000000
 #define R31		31
 
+// Double-length multiply, shared by the interpreter and the block
+// translator (defined in mipssim.cc)
+extern void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
+
 /*
  * The table below is used to translate bits 31:26 of the instruction
  * into a value suitable for the "opCode" field of a MemWord structure,
@@ -22,6 +22,21 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numSwapReads = numSwapWrites = 0;
+    numCacheWrites = numCacheRejects = 0;
+    numCacheReads = numCachePushOuts = 0;
+    numExeReads = numZeroFills = numTextShared = 0;
+    numCowShared = numCowCopies = 0;
+    numEvictions = numDirtyEvictions = 0;
+    numCleanerRuns = numPagesCleaned = 0;
+    numPoolHits = numPoolMisses = 0;
+    numReclaimRuns = numFramesReclaimed = 0;
+    numPageTablesMade = numPageTablesFreed = 0;
+    numQuotaRaises = numQuotaCuts = 0;
+    numPrefetched = numPrefetchHits = numPrefetchWasted = 0;
+    numMicroTLBHits = numMicroTLBMisses = 0;
+    numTLBHits = numTLBMisses = 0;
+    numTLBFlushes = numTLBFlushesAvoided = 0;
 }
 
 //----------------------------------------------------------------------
@@ -39,6 +54,50 @@ Statistics::Print()
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
     printf("Paging: faults %d\n", numPageFaults);
+    if (numSwapReads + numSwapWrites > 0)
+	printf("Swap I/O: reads %d, writes %d\n", numSwapReads, numSwapWrites);
+    if (numCacheWrites + numCacheRejects > 0)
+	printf("Compressed cache: pages kept %d, too big %d, read back %d, "
+	    "pushed out to swap %d\n", numCacheWrites, numCacheRejects,
+	    numCacheReads, numCachePushOuts);
+    if (numExeReads + numZeroFills > 0)
+	printf("First touch: read from executable %d, zero-filled %d\n",
+	    numExeReads, numZeroFills);
+    if (numTextShared > 0)
+	printf("Shared text: faults served from memory %d\n", numTextShared);
+    if (numCowShared > 0)
+	printf("Copy-on-write: pages shared %d, copied %d\n", numCowShared,
+	    numCowCopies);
+    if (numEvictions > 0)
+	printf("Evictions: %d, of dirty pages %d\n", numEvictions,
+	    numDirtyEvictions);
+    if (numCleanerRuns > 0)
+	printf("Page cleaner: runs %d, pages written %d\n", numCleanerRuns,
+	    numPagesCleaned);
+    if (numPoolHits + numPoolMisses > 0)
+	printf("Free-frame pool: faults served %d, evicting %d; reclaimer "
+	    "runs %d, pages evicted %d\n", numPoolHits, numPoolMisses,
+	    numReclaimRuns, numFramesReclaimed);
+    if (numPageTablesMade > 0)
+	printf("Radix page tables: made %d, freed when empty %d\n",
+	    numPageTablesMade, numPageTablesFreed);
+    if (numQuotaRaises + numQuotaCuts > 0)
+	printf("Frame quotas: raised %d, lowered %d\n", numQuotaRaises,
+	    numQuotaCuts);
+    if (numPrefetched > 0)
+	printf("Prefetch: pages %d, used %d, wasted %d\n", numPrefetched,
+	    numPrefetchHits, numPrefetchWasted);
+    if (numMicroTLBHits + numMicroTLBMisses > 0)
+	printf("Micro-TLB: hits %d, misses %d (%d%% hit rate)\n",
+	    numMicroTLBHits, numMicroTLBMisses, (int) (100.0 * numMicroTLBHits
+		/ ((double) numMicroTLBHits + numMicroTLBMisses)));
+    if (numTLBHits + numTLBMisses > 0)
+	printf("TLB: hits %d, misses %d (%d%% hit rate)\n",
+	    numTLBHits, numTLBMisses, (int) (100.0 * numTLBHits
+		/ ((double) numTLBHits + numTLBMisses)));
+    if (numTLBFlushes + numTLBFlushesAvoided > 0)
+	printf("TLB flushes: %d, avoided %d\n", numTLBFlushes,
+	    numTLBFlushesAvoided);
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
 }
@@ -33,8 +33,44 @@ class Statistics {
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
+    int numSwapReads;		// pages read in from swap
+    int numSwapWrites;		// pages written out to swap
+    int numCacheWrites;		// pages kept compressed instead (-Z)
+    int numCacheRejects;	// ... or that didn't compress well
+    int numCacheReads;		// pages read back from the cache
+    int numCachePushOuts;	// pages it wrote to swap to make room
+    int numExeReads;		// pages read in from the executable
+    int numZeroFills;		// pages zero-filled instead of read in
+    int numTextShared;		// faults on text another process had
+				// in memory already
+    int numCowShared;		// pages a Fork left in both processes
+    int numCowCopies;		// ... that one of them copied to write
+    int numEvictions;		// pages replaced to make room
+    int numDirtyEvictions;	// ... that had to be written first
+    int numCleanerRuns;		// times the page cleaner ran (-CL)
+    int numPagesCleaned;	// pages it wrote back
+    int numPoolHits;		// faults that found a free frame (-FP)
+    int numPoolMisses;		// ... or had to evict a page themselves
+    int numReclaimRuns;		// times the reclaimer ran
+    int numFramesReclaimed;	// pages it evicted
+    int numPageTablesMade;	// radix page tables allocated (-H)
+    int numPageTablesFreed;	// ... and freed once empty
+    int numQuotaRaises;		// times a process was allowed another
+				// frame (-PFF)
+    int numQuotaCuts;		// ... or made to give one up
+    int numPrefetched;		// pages brought in ahead of a fault (-FA)
+    int numPrefetchHits;	// ... that were used
+    int numPrefetchWasted;	// ... that went out again unused
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numMicroTLBHits;	// translations found in the micro-TLB
+    int numMicroTLBMisses;	// translations that walked the page table
+    int numTLBHits;		// translations found in the TLB
+    int numTLBMisses;		// translations the kernel had to refill
+    int numTLBFlushes;		// context switches (or ASID reuses) that
+				// emptied the TLB of an address space
+    int numTLBFlushesAvoided;	// context switches that left the TLB
+				// alone, because its entries are tagged
 
     Statistics(); 		// initialize everything to zero
 
@@ -4,11 +4,14 @@
 //	in the table on every memory reference to find the true physical
 //	memory location.
 //
-// Two types of translation are supported here.
+// Three types of translation are supported here.
 //
 //	Linear page table -- the virtual page # is used as an index
 //	into the table, to find the physical page #.
 //
+//	Radix page table (-H) -- a tree of tables, each level indexed
+//	by the next few bits of the virtual page #; see RadixTable.
+//
 //	Translation lookaside buffer -- associative lookup in the table
 //	to find an entry with the same virtual page #.  If found,
 //	this entry is used for the translation.
@@ -165,6 +168,7 @@ Machine::WriteMem(int addr, int size, int value)
 	
       default: ASSERT(FALSE);
     }
+    NoteWrite(physicalAddress);
     
     return TRUE;
 }
@@ -192,6 +196,25 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     unsigned int vpn, offset;
     TranslationEntry *entry;
     unsigned int pageFrame;
+    MicroTLBEntry *cached;
+
+// first see if the micro-TLB remembers this page; an aligned reference
+// to a page that is still valid needs no more checking than that
+    vpn = (unsigned) virtAddr / PageSize;
+    cached = &microTLB[vpn % MicroTLBSize];
+    if (cached->virtualPage == (int) vpn && cached->entry->valid
+		&& (cached->writable || !writing) 
+		&& !(virtAddr & (size - 1))) {
+	stats->numMicroTLBHits++;
+	cached->entry->use = TRUE;
+	if (writing)
+	    cached->entry->dirty = TRUE;
+	*physAddr = cached->frameBase + (unsigned) virtAddr % PageSize;
+	return NoException;
+    }
+    if (tlb == NULL)
+	stats->numMicroTLBMisses++;
+
     DEBUG('a', "\tTranslate 0x%x, %s: ", virtAddr, writing ? "write" : "read");
 
 // check for alignment errors
@@ -216,36 +239,46 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
       offset = (unsigned) virtAddr % PageSize;
       
 
+      if (tlb != NULL) {		// => TLB, refilled by the kernel
+          for (entry = NULL, i = 0; i < tlbSize; i++)
+      	    if (tlb[i].valid && (((unsigned int)tlb[i].virtualPage) == vpn)
+		    && tlb[i].asid == tlbAsid) {
+  		        entry = &tlb[i];			// FOUND!
+  		    break;
+  	    }
+      	if (entry == NULL) {				// not found
+      	    DEBUG('a', "*** no valid TLB entry found for this virtual page!\n");
+      	    stats->numTLBMisses++;
+      	    return PageFaultException;		// really, this is a TLB fault,
+      						// the page may be in memory,
+      						// but not in the TLB
+      	}
+      	stats->numTLBHits++;
+
       //begin code changes by joseph kokenge
-      if (isTwoLevel) {
-        //get the correct page table "coordinates"
+      } else if (isTwoLevel) {
+        //walk the radix table down to the page's entry
 
-        int outerIndex = vpn/AddrSpace::innerTableSize;
-        int innerIndex = vpn%AddrSpace::innerTableSize;
-        //printf("TRANSLATEouterIndex: %d\n", outerIndex);
-        //printf("TRANSLATEinnerIndex: %d\n", innerIndex);
-        
-        if (vpn >= twoLevelPageTableSize) {
+        if (vpn >= (unsigned) radixTable->NumPages()) {
           printf("two level: too lardge\n");
         	  return AddressErrorException;
         	} 
         
-        if (outerPageTable[outerIndex] == NULL) {
+        entry = radixTable->Lookup(vpn);
+        if (entry == NULL) {
           printf("MISS: Creating new pageTable\n");
           
 
           return PageFaultException;
-        } else if (!outerPageTable[outerIndex][innerIndex].valid) {
+        } else if (!entry->valid) {
           printf("two level: invalid page in innertable\n");
 
           return PageFaultException;
         }
 
-
-        entry = &outerPageTable[outerIndex][innerIndex];
     //end code changes by joseph kokenge
 
-      } else if (tlb == NULL) {		// => page table => vpn is index into table
+      } else {		// => page table => vpn is index into table
       	if (vpn >= pageTableSize) {
       	    DEBUG('a', "virtual page # %d too large for page table size %d!\n", 
       			virtAddr, pageTableSize);
@@ -256,23 +289,6 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
       	    return PageFaultException;
       	}
       	entry = &pageTable[vpn];
-      } else {
-          for (entry = NULL, i = 0; i < TLBSize; i++)
-      	    if (tlb[i].valid && (((unsigned int)tlb[i].virtualPage) == vpn)) {
-  		        entry = &tlb[i];			// FOUND!
-  		    break;
-  	    }
-  
-  
-  
-  
-  
-      	if (entry == NULL) {				// not found
-          	    DEBUG('a', "*** no valid TLB entry found for this virtual page!\n");
-          	    return PageFaultException;		// really, this is a TLB fault,
-      						// the page may be in memory,
-      						// but not in the TLB
-      	}
       }
       if (entry->readOnly && writing) {	// trying to write to a read-only page
       	DEBUG('a', "%d mapped read-only at %d in TLB!\n", virtAddr, i);
@@ -282,7 +298,7 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 
       // if the pageFrame is too big, there is something really wrong! 
       // An invalid translation was loaded into the page table or TLB. 
-      if (pageFrame >= NumPhysPages) { 
+      if (pageFrame >= (unsigned) NumPhysPages) { 
       	DEBUG('a', "*** frame %d > %d!\n", pageFrame, NumPhysPages);
       	return BusErrorException;
       }
@@ -295,8 +311,257 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
       *physAddr = pageFrame * PageSize + offset;
       ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
 
+      // remember page table lookups (not the TLB's: the kernel manages
+      // that), unless we're tracing every translation
+      if (tlb == NULL && !DebugIsEnabled('a')) {
+	cached->virtualPage = vpn;
+	cached->frameBase = pageFrame * PageSize;
+	cached->writable = !entry->readOnly;
+	cached->entry = entry;
+      }
+
       DEBUG('a', "phys addr = 0x%x\n", *physAddr);
 
       return NoException;
     
 }
+
+//----------------------------------------------------------------------
+// Machine::FlushMicroTLB
+// 	Forget cached translations, because the page table they came 
+//	from is being switched out, or one of its entries is changing.
+//
+//	"vpn" -- if given, only forget this virtual page
+//----------------------------------------------------------------------
+
+void
+Machine::FlushMicroTLB()
+{
+    for (int i = 0; i < MicroTLBSize; i++)
+	microTLB[i].virtualPage = -1;
+}
+
+void
+Machine::FlushMicroTLB(int vpn)
+{
+    if (microTLB[vpn % MicroTLBSize].virtualPage == vpn)
+	microTLB[vpn % MicroTLBSize].virtualPage = -1;
+}
+
+int RadixTable::levels = 2;
+int RadixTable::fanBits = 4;
+
+//----------------------------------------------------------------------
+// RadixTable::RadixTable
+// 	Make an empty radix page table mapping "size" pages: just the
+//	root, with enough entries to cover them all.
+//
+//	A table below the root is a leaf if the slot holding it was
+//	indexed with a shift of "fanBits", and holds the tables of the
+//	next level down otherwise; that shift is passed along with it.
+//----------------------------------------------------------------------
+
+RadixTable::RadixTable(int size)
+{
+    ASSERT(levels >= 2 && fanBits >= 1);
+    numPages = size;
+    rootShift = fanBits * (levels - 1);
+    rootSize = max(1, divRoundUp(size, 1 << rootShift));
+    root = new void *[rootSize];
+    for (int i = 0; i < rootSize; i++)
+	root[i] = NULL;
+}
+
+RadixTable::RadixTable(RadixTable *other)
+{
+    numPages = other->numPages;
+    rootShift = other->rootShift;
+    rootSize = other->rootSize;
+    root = new void *[rootSize];
+    for (int i = 0; i < rootSize; i++)
+	root[i] = other->root[i] == NULL ? NULL
+			: CopyTable(other->root[i], rootShift);
+}
+
+RadixTable::~RadixTable()
+{
+    for (int i = 0; i < rootSize; i++)
+	if (root[i] != NULL)
+	    DeleteTable(root[i], rootShift);
+    delete [] root;
+}
+
+//----------------------------------------------------------------------
+// RadixTable::Lookup
+// 	Walk down to the entry for "vPage", a level at a time.  Return 
+//	NULL if it is out of range, or a table on the way hasn't been 
+//	made (none of the pages under it is in memory).
+//----------------------------------------------------------------------
+
+TranslationEntry *
+RadixTable::Lookup(unsigned int vPage)
+{
+    int shift = rootShift;
+    void *table;
+
+    if (vPage >= (unsigned) numPages)
+	return NULL;
+    table = root[vPage >> shift];
+    while (table != NULL && shift > fanBits) {
+	shift -= fanBits;
+	table = ((void **) table)[(vPage >> shift) & ((1 << fanBits) - 1)];
+    }
+    if (table == NULL)
+	return NULL;
+    return &((TranslationEntry *) table)[vPage & ((1 << fanBits) - 1)];
+}
+
+//----------------------------------------------------------------------
+// RadixTable::Make
+// 	Return the entry for "vPage", making the tables on the way down
+//	to it that don't exist yet.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+RadixTable::Make(int vPage)
+{
+    int shift = rootShift;
+    void **slot;
+
+    ASSERT(vPage >= 0 && vPage < numPages);
+    slot = &root[vPage >> shift];
+    for (;;) {
+	if (*slot == NULL)
+	    *slot = NewTable(shift, vPage);
+	if (shift == fanBits)
+	    break;
+	shift -= fanBits;
+	slot = &((void **) *slot)[(vPage >> shift) & ((1 << fanBits) - 1)];
+    }
+    return &((TranslationEntry *) *slot)[vPage & ((1 << fanBits) - 1)];
+}
+
+//----------------------------------------------------------------------
+// RadixTable::Prune
+// 	"vPage" has just been taken out of memory.  If that leaves its
+//	leaf with no valid entries, free it, and then any table above
+//	it left empty, up to (not including) the root.
+//----------------------------------------------------------------------
+
+void
+RadixTable::Prune(int vPage)
+{
+    void **slot = &root[vPage >> rootShift];
+
+    if (*slot != NULL && PruneTable(*slot, rootShift, vPage))
+	*slot = NULL;
+}
+
+//----------------------------------------------------------------------
+// RadixTable::PruneTable
+// 	Prune the path to "vPage" in "table", indexed with "shift", and
+//	return TRUE if "table" itself was freed.
+//----------------------------------------------------------------------
+
+bool
+RadixTable::PruneTable(void *table, int shift, int vPage)
+{
+    int fanOut = 1 << fanBits;
+    int i;
+
+    if (shift == fanBits) {
+	TranslationEntry *leaf = (TranslationEntry *) table;
+
+	for (i = 0; i < fanOut; i++)
+	    if (leaf[i].valid)
+		return FALSE;
+    } else {
+	void **inner = (void **) table;
+	int index = (vPage >> (shift - fanBits)) & (fanOut - 1);
+
+	if (inner[index] == NULL 
+		|| !PruneTable(inner[index], shift - fanBits, vPage))
+	    return FALSE;
+	inner[index] = NULL;
+	for (i = 0; i < fanOut; i++)
+	    if (inner[i] != NULL)
+		return FALSE;
+    }
+    DeleteTable(table, shift);
+    stats->numPageTablesFreed++;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// RadixTable::NewTable, CopyTable, DeleteTable
+// 	Make an empty table to go in a slot indexed with "shift", on the
+//	way to "vPage"; copy one, with everything below it; and free one,
+//	with everything below it.
+//----------------------------------------------------------------------
+
+void *
+RadixTable::NewTable(int shift, int vPage)
+{
+    int fanOut = 1 << fanBits;
+    int i;
+
+    stats->numPageTablesMade++;
+    if (shift == fanBits) {
+	TranslationEntry *leaf = new TranslationEntry[fanOut];
+	int first = vPage & ~(fanOut - 1);
+
+	for (i = 0; i < fanOut; i++) {
+	    leaf[i].virtualPage = first + i;
+	    leaf[i].physicalPage = -1;
+	    leaf[i].valid = FALSE;
+	    leaf[i].use = FALSE;
+	    leaf[i].dirty = FALSE;
+	    leaf[i].readOnly = FALSE;
+	    leaf[i].asid = 0;
+	}
+	printf("made a new page table\n");
+	return leaf;
+    }
+
+    void **inner = new void *[fanOut];
+
+    for (i = 0; i < fanOut; i++)
+	inner[i] = NULL;
+    return inner;
+}
+
+void *
+RadixTable::CopyTable(void *table, int shift)
+{
+    int fanOut = 1 << fanBits;
+    int i;
+
+    stats->numPageTablesMade++;
+    if (shift == fanBits) {
+	TranslationEntry *leaf = new TranslationEntry[fanOut];
+
+	for (i = 0; i < fanOut; i++)
+	    leaf[i] = ((TranslationEntry *) table)[i];
+	return leaf;
+    }
+
+    void **inner = new void *[fanOut];
+
+    for (i = 0; i < fanOut; i++)
+	inner[i] = ((void **) table)[i] == NULL ? NULL
+			: CopyTable(((void **) table)[i], shift - fanBits);
+    return inner;
+}
+
+void
+RadixTable::DeleteTable(void *table, int shift)
+{
+    if (shift == fanBits) {
+	delete [] (TranslationEntry *) table;
+	return;
+    }
+    for (int i = 0; i < (1 << fanBits); i++)
+	if (((void **) table)[i] != NULL)
+	    DeleteTable(((void **) table)[i], shift - fanBits);
+    delete [] (void **) table;
+}
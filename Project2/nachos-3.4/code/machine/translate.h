@@ -40,8 +40,67 @@ class TranslationEntry {
 			// page is referenced or modified.
     bool dirty;         // This bit is set by the hardware every time the
 			// page is modified.
+    int asid;		// In a TLB entry, the address space it belongs
+			// to; it only matches while Machine::tlbAsid is
+			// the same.  Unused in a page table.
 
 
 };
 
+// One slot of the micro-TLB, a host-side cache the simulator keeps of
+// recent page table lookups (see Machine::Translate).  Unlike the 
+// "tlb", it is invisible to the Nachos kernel.
+
+class MicroTLBEntry {
+  public:
+    int virtualPage;		// page this slot translates, or -1
+    int frameBase;		// physicalPage * PageSize
+    bool writable;		// FALSE if the page is read-only
+    TranslationEntry *entry;	// where the translation came from, for
+				// the valid, use and dirty bits
+};
+
+// A radix page table (-H): a tree of tables "levels" deep, each level
+// indexed by the next "fanBits" bits of the virtual page number, 
+// the root by whatever bits are left.  The leaves hold the page table
+// entries themselves.  Tables below the root are only made when a page
+// in their range is brought in, and freed again once none of their
+// pages is in memory, so a big, sparse address space costs no more
+// page table than the pages it has in use.
+//
+// Entries of pages that are not in memory hold nothing worth keeping:
+// where such a page is in swap is kept by the address space.
+
+class RadixTable {
+  public:
+    RadixTable(int size);		// map pages 0 to size-1, with no
+					// tables below the root yet
+    RadixTable(RadixTable *other);	// a copy of "other" (Fork)
+    ~RadixTable();
+
+    int NumPages() { return numPages; }
+    TranslationEntry *Lookup(unsigned int vPage);
+					// vPage's entry, or NULL if it has
+					// no leaf, or is out of range
+    TranslationEntry *Make(int vPage);	// ... making its tables if need be
+    void Prune(int vPage);		// free vPage's leaf, and the tables
+					// above it, if none of their pages
+					// is valid any more
+
+    static int levels;			// the shape of every radix table:
+    static int fanBits;			// set by -HL and -HF
+
+  private:
+    void **root;			// tables at the next level down,
+					// or NULL
+    int rootSize;			// entries in "root"
+    int rootShift;			// vPage >> rootShift indexes it
+    int numPages;			// pages mapped
+
+    void *NewTable(int shift, int vPage);
+    void *CopyTable(void *table, int shift);
+    void DeleteTable(void *table, int shift);
+    bool PruneTable(void *table, int shift, int vPage);
+};
+
 #endif
@@ -0,0 +1,60 @@
+/* forkcow.c
+ *    Test program for Fork and its copy-on-write address spaces.
+ *
+ *    Parent and child each write their own value into the same global
+ *    variables, give the other a chance to run, and then check that
+ *    they still see their own values.  Each checks what Fork returned
+ *    to it: 0 in the child, the child's id in the parent.
+ *
+ *    Both exit with 0 if all is well, or with a code saying what went
+ *    wrong: 1x in the child, 2x in the parent.
+ */
+
+#include "syscall.h"
+
+#define Size	256	/* spans several pages */
+
+int shared = 1;
+int A[Size];
+
+int
+check(int value, int code)
+{
+    int i;
+
+    if (shared != value)
+	return code;
+    for (i = 0; i < Size; i++)
+	if (A[i] != value + i)
+	    return code + 1;
+    return 0;
+}
+
+int
+main()
+{
+    int i, pid, error;
+
+    for (i = 0; i < Size; i++)		/* in memory before the Fork */
+	A[i] = 1 + i;
+
+    pid = Fork();
+    if (pid == 0) {			/* the child */
+	if ((error = check(1, 10)) != 0)	/* sees the parent's memory... */
+	    Exit(error);
+	shared = 2;			/* ...but its writes are its own */
+	for (i = 0; i < Size; i++)
+	    A[i] = 2 + i;
+	Yield();
+	Exit(check(2, 12));
+    }
+
+    /* the parent */
+    if (pid <= 0)
+	Exit(20);
+    shared = 3;
+    for (i = 0; i < Size; i++)
+	A[i] = 3 + i;
+    Yield();
+    Exit(check(3, 22));
+}
@@ -23,6 +23,38 @@
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
 //    -x runs a user program
+//    -F runs user programs on the threaded interpreter
+//    -B runs user programs on the basic-block translator
+//    -TLB translates through a TLB refilled by the kernel, replacing
+//	entries at random (-TLB 1) or by clock (-TLB 2)
+//    -TS sets the number of TLB entries
+//    -ASID tags TLB entries with an address space id, so they need
+//	not be flushed on a context switch (implies -TLB 1 if no -TLB)
+//    -P profiles user programs, printing the results at halt
+//    -V picks the page to replace by FIFO (-V 1), at random (-V 2),
+//	by clock (-V 3), by enhanced NRU, preferring clean pages (-V 4),
+//	by aging, an approximation of LRU (-V 5), or by ARC (-V 6)
+//    -PFF gives each process a quota of frames, set by how often it
+//	faults, and replaces its own pages once it has them all (implies
+//	-V 3 if no -V)
+//    -FA also brings in the pages after a faulting one, while there
+//	are free frames, as many as have lately turned out to be used
+//    -CL runs a page cleaner thread, which writes dirty pages to swap
+//	before they are chosen for replacement
+//    -FP <low> <high> keeps a pool of free frames: when a page fault
+//	leaves fewer than <low>, a reclaim thread evicts pages until
+//	<high> are free
+//    -H translates through a radix page table, whose tables below the
+//	root are only there while some page under them is in memory
+//    -HL sets the number of levels in it (2 by default)
+//    -HF sets the fan-out of each level below the root (16 by default,
+//	and a power of two)
+//    -NP sets the number of pages of physical memory (32 by default)
+//    -PS sets the page size, in bytes (the disk sector size by default)
+//    -Z <bytes> keeps pages written to swap compressed in memory, up to
+//	<bytes> of them, if they compress to three quarters of a page or less
+//    -ZT checks that pages of several kinds come back from -Z's
+//	compression unchanged, and prints how small they get
 //    -c tests the console
 //
 //  FILESYS
@@ -59,6 +91,7 @@ extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
 extern void Print(char *file), PerformanceTest(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out);
 extern void MailTest(int networkID);
+extern void CompressTest(void);
 
 //----------------------------------------------------------------------
 // main
@@ -111,6 +144,8 @@ main(int argc, char **argv)
 	    interrupt->Halt();		// once we start the console, then 
 					// Nachos will loop forever waiting 
 					// for console input
+	} else if (!strcmp(*argv, "-ZT")) {	// test -Z's compression
+	    CompressTest();
 	}
 #endif // USER_PROGRAM
 #ifdef FILESYS
@@ -58,6 +58,19 @@ Scheduler::ReadyToRun (Thread *thread)
     readyList->Append((void *)thread);
 }
 
+//----------------------------------------------------------------------
+// Scheduler::ReadyToRunFirst
+// 	Like ReadyToRun, but put the thread on the front of the ready
+//	list, so it is the next to be scheduled.
+//----------------------------------------------------------------------
+
+void
+Scheduler::ReadyToRunFirst (Thread *thread)
+{
+    thread->setStatus(READY);
+    readyList->Prepend((void *)thread);
+}
+
 //----------------------------------------------------------------------
 // Scheduler::FindNextToRun
 // 	Return the next thread to be scheduled onto the CPU.
@@ -8,6 +8,9 @@
 #include "copyright.h"
 #include "system.h"
 #include "machine.h"
+#ifdef USER_PROGRAM
+#include "addrspace.h"
+#endif
 
 // This defines *all* of the global data structures used by Nachos.
 // These are all initialized and de-allocated by this file.
@@ -22,14 +25,25 @@ Timer *timer;				// the hardware timer device,
 int threadChoice;
 int memChoice;
 int repChoice = 0;
+int simChoice = 0;	// 0 = reference interpreter, 1 = threaded (-F),
+			// 2 = basic-block translator (-B)
+int tlbChoice = 0;	// 0 = page tables only, 1 = TLB with random
+			// replacement, 2 = TLB with clock (-TLB)
+int tlbEntries = 0;	// TLB size (-TS), or 0 for TLBSize
+bool asidTagging = false; // tag TLB entries by address space (-ASID)
+bool profiling = false;	// count user instructions (-P)
+bool localReplacement = false; // per-process frame quotas (-PFF)
+bool faultAround = false;	// prefetch after page faults (-FA)
+bool pageCleaning = false;	// run the page cleaner (-CL)
+int poolLowWater = 0;		// free-frame pool watermarks (-FP), or 0
+int poolHighWater = 0;		// for no pool
+int zcacheBytes = 0;		// compressed swap cache size (-Z), or 0
 bool isTwoLevel = false; // code changes by joseph kokenge
 bool extraInput;
 bool pageFlag;
 int faultcount = 0;
 
 BitMap * memMap;
-Thread ** ipt = new Thread*[NumPhysPages];
-List fifo; //for fifo in task 4 proj 4
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -39,6 +53,12 @@ FileSystem  *fileSystem;
 Machine *machine;	// user program memory and registers
 List* activeThreads;
 int threadID;
+SwapManager *swapManager;	// the swap device
+FrameEntry *frameTable;		// owner of each physical page
+ReplacementPolicy *replacer;	// the page replacement policy, or NULL
+PageCleaner *cleaner;		// the page cleaner, or NULL
+FrameReclaimer *reclaimer;	// keeps frames free (-FP), or NULL
+TextCache *textCache;		// programs whose text is being shared
 #endif
 
 #ifdef FILESYS
@@ -71,11 +91,25 @@ extern void Cleanup();
 //	"dummy" is because every interrupt handler takes one argument,
 //		whether it needs it or not.
 //----------------------------------------------------------------------
+static bool timeSlicing = FALSE;	// does the timer cause context switches?
+
 static void
 TimerInterruptHandler(int dummy)
 {
-    if (interrupt->getStatus() != IdleMode)
+    bool idle = (interrupt->getStatus() == IdleMode);
+
+    if (timeSlicing && !idle)
 	interrupt->YieldOnReturn();
+#ifdef USER_PROGRAM
+    if (replacer != NULL && replacer->NeedsSampling())
+	replacer->Sample();	// the page replacement policy may
+				// want to look at use bits
+    if (cleaner != NULL && cleaner->Tick() && !idle)
+	interrupt->YieldOnReturn(TRUE);	// let the page cleaner run, 
+					// then carry on
+    if (reclaimer != NULL && reclaimer->Pending() && !idle)
+	interrupt->YieldOnReturn(TRUE);	// ... and the reclaimer
+#endif
 }
 
 //----------------------------------------------------------------------
@@ -154,6 +188,80 @@ Initialize(int argc, char **argv)
       isTwoLevel = true;
   }
   //end edit by joseph kokenge
+	else if (!strcmp(*argv, "-F")) {	// threaded interpreter
+	    simChoice = 1;
+	}
+	else if (!strcmp(*argv, "-B")) {	// basic-block translator
+	    simChoice = 2;
+	}
+	else if (!strcmp(*argv, "-TLB")) {	// translate through a TLB
+	    if(*(argv+1) == NULL)
+			tlbChoice = 1;
+	    else
+			tlbChoice = atoi(*(argv+1));
+	    argCount = 2;
+	}
+	else if (!strcmp(*argv, "-TS")) {	// TLB size
+	    ASSERT(argc > 1);
+	    tlbEntries = atoi(*(argv+1));
+	    argCount = 2;
+	}
+	else if (!strcmp(*argv, "-ASID")) {	// tagged TLB entries
+	    asidTagging = true;
+	}
+	else if (!strcmp(*argv, "-P")) {	// profile user programs
+	    profiling = true;
+	}
+	else if (!strcmp(*argv, "-PFF")) {	// per-process frame quotas
+	    localReplacement = true;
+	}
+	else if (!strcmp(*argv, "-FA")) {	// fault-around
+	    faultAround = true;
+	}
+	else if (!strcmp(*argv, "-CL")) {	// page cleaner
+	    pageCleaning = true;
+	}
+	else if (!strcmp(*argv, "-FP")) {	// free-frame pool
+	    ASSERT(argc > 2);
+	    poolLowWater = atoi(*(argv+1));
+	    poolHighWater = atoi(*(argv+2));
+	    argCount = 3;
+	}
+#ifdef USER_PROGRAM			// the machine is only there then
+	else if (!strcmp(*argv, "-NP")) {	// physical memory size
+	    ASSERT(argc > 1);
+	    numPhysPages = atoi(*(argv+1));
+	    ASSERT(numPhysPages > 0);
+	    argCount = 2;
+	}
+	else if (!strcmp(*argv, "-PS")) {	// page size
+	    ASSERT(argc > 1);
+	    pageSize = atoi(*(argv+1));
+	    ASSERT(pageSize >= 16 && pageSize % 4 == 0);
+	    argCount = 2;
+	}
+	else if (!strcmp(*argv, "-HL")) {	// radix table levels
+	    ASSERT(argc > 1);
+	    RadixTable::levels = atoi(*(argv+1));
+	    ASSERT(RadixTable::levels >= 2);
+	    argCount = 2;
+	}
+	else if (!strcmp(*argv, "-HF")) {	// radix table fan-out
+	    ASSERT(argc > 1);
+	    int fanOut = atoi(*(argv+1));
+
+	    for (RadixTable::fanBits = 0; (1 << RadixTable::fanBits) < fanOut;
+			RadixTable::fanBits++)
+		;
+	    ASSERT(fanOut >= 2 && (1 << RadixTable::fanBits) == fanOut);
+	    argCount = 2;
+	}
+#endif
+	else if (!strcmp(*argv, "-Z")) {	// compressed swap cache
+	    ASSERT(argc > 1);
+	    zcacheBytes = atoi(*(argv+1));
+	    argCount = 2;
+	}
 
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
@@ -182,6 +290,7 @@ Initialize(int argc, char **argv)
     stats = new Statistics();			// collect statistics
     interrupt = new Interrupt;			// start up interrupt handling
     scheduler = new Scheduler();		// initialize the ready queue
+    timeSlicing = randomYield;
     if (randomYield)				// start the timer (if needed)
 	timer = new Timer(TimerInterruptHandler, 0, randomYield);
 
@@ -200,7 +309,21 @@ Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
 	memMap = new BitMap(NumPhysPages);
+	frameTable = new FrameEntry[NumPhysPages];
+	textCache = new TextCache();
+	if (localReplacement && repChoice <= 0)
+		repChoice = 3;		// -PFF alone implies -V 3
+	replacer = NewReplacementPolicy(repChoice);
+	if (replacer == NULL)
+		poolHighWater = 0;	// nothing could be evicted
+	if (timer == NULL && (pageCleaning || poolHighWater > 0
+			|| (replacer != NULL && replacer->NeedsSampling())))
+		timer = new Timer(TimerInterruptHandler, 0, FALSE);
 	machine = new Machine(debugUserProg);
+	if (asidTagging && tlbChoice == 0)
+		tlbChoice = 1;		// -ASID alone implies -TLB 1
+	if (tlbChoice != 0)
+		machine->EnableTLB(tlbEntries > 0 ? tlbEntries : TLBSize);
 
 
 	activeThreads = new List();	// Make the active threads list.
@@ -214,6 +337,14 @@ Initialize(int argc, char **argv)
     fileSystem = new FileSystem(format);
 #endif
 
+#ifdef USER_PROGRAM
+    swapManager = new SwapManager(SwapFileName, zcacheBytes);
+    if (pageCleaning)
+	cleaner = new PageCleaner();
+    if (poolHighWater > 0)
+	reclaimer = new FrameReclaimer(poolLowWater, poolHighWater);
+#endif
+
 #ifdef NETWORK
     postOffice = new PostOffice(netname, rely, 10);
 #endif
@@ -235,6 +366,12 @@ Cleanup()
     delete machine;
 	delete activeThreads;
 	delete memMap;
+	delete [] frameTable;
+	delete textCache;
+	delete replacer;
+	delete cleaner;
+	delete reclaimer;
+	delete swapManager;
 #endif
 
 #ifdef FILESYS_NEEDED
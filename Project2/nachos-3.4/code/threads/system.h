@@ -33,18 +33,36 @@ extern Timer *timer;				// the hardware alarm clock
 extern int threadChoice;
 extern int memChoice;
 extern int repChoice;
+extern int simChoice;				// which user instruction loop to use
+extern int tlbChoice;				// TLB replacement, 0 if no TLB
+extern int tlbEntries;				// TLB size, 0 for the default
+extern bool asidTagging;			// TLB entries carry an ASID
+extern bool profiling;				// profile user programs
+extern bool localReplacement;			// replace within frame quotas
+extern bool faultAround;			// prefetch on page faults
+extern bool pageCleaning;			// write back dirty pages early
 extern int faultcount;
 extern bool isTwoLevel; // code changes by joseph kokenge
 extern bool extraInput;
 extern bool pageFlag;
-extern Thread **ipt;				//AH - Define IPT
 extern BitMap *memMap;				//Bitmap to keep track of memory use
-extern List fifo;
 #ifdef USER_PROGRAM
 #include "machine.h"
 extern Machine* machine;	// user program memory and registers
 extern List* activeThreads;	// active thread list for process management
 extern int threadID;	// unique process id
+#include "swap.h"
+extern SwapManager *swapManager;	// backing store for user pages
+class FrameEntry;
+extern FrameEntry *frameTable;	// what is in each physical page
+#include "replace.h"
+extern ReplacementPolicy *replacer;	// picks pages to evict (-V)
+#include "cleaner.h"
+extern PageCleaner *cleaner;		// writes back dirty pages (-CL)
+#include "reclaim.h"
+extern FrameReclaimer *reclaimer;	// keeps frames free (-FP)
+#include "textcache.h"
+extern TextCache *textCache;		// text pages shared by processes
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB
@@ -192,7 +192,9 @@ Thread::Finish ()
 // Thread::Yield
 // 	Relinquish the CPU if any other thread is ready to run.
 //	If so, put the thread on the end of the ready list, so that
-//	it will eventually be re-scheduled.
+//	it will eventually be re-scheduled -- or, if "keepPlace", on 
+//	the front, so that it runs again as soon as the thread it 
+//	yields to gives up the CPU.
 //
 //	NOTE: returns immediately if no other thread on the ready queue.
 //	Otherwise returns when the thread eventually works its way
@@ -207,7 +209,7 @@ Thread::Finish ()
 //----------------------------------------------------------------------
 
 void
-Thread::Yield ()
+Thread::Yield (bool keepPlace)
 {
     Thread *nextThread;
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
@@ -220,7 +222,10 @@ Thread::Yield ()
     nextThread = scheduler->FindNextToRun();
     if (nextThread != NULL) {
 	//printf("%i.\n",nextThread->getID());
-	scheduler->ReadyToRun(this);
+	if (keepPlace)
+	    scheduler->ReadyToRunFirst(this);
+	else
+	    scheduler->ReadyToRun(this);
 	scheduler->Run(nextThread);
     }
     (void) interrupt->SetLevel(oldLevel);
@@ -92,8 +92,9 @@ class Thread {
     // basic thread operations
 
     void Fork(VoidFunctionPtr func, int arg); 	// Make thread run (*func)(arg)
-    void Yield();  				// Relinquish the CPU if any 
-						// other thread is runnable
+    void Yield(bool keepPlace = FALSE);	// Relinquish the CPU if any 
+						// other thread is runnable; if
+						// "keepPlace", run again next
     void Sleep();  				// Put the thread to sleep and 
 						// relinquish the processor
     void Finish();  				// The thread is done executing
@@ -19,6 +19,34 @@
 #include "system.h"
 #include "addrspace.h"
 #include "noff.h"
+#include "profile.h"
+
+static void ReleaseTLBEntry(TranslationEntry *tlbEntry);
+
+static AddrSpace *asidOwner[NumASIDs];	// space holding each ASID, or NULL
+static int asidHand = 0;		// next ASID to take back, once all
+					// are in use
+static AddrSpace *allSpaces = NULL;	// every address space, to find the
+					// ones sharing a frame after a Fork
+static int *prefetchPrev = NULL;	// links for each space's list of
+static int *prefetchNext = NULL;	// frames brought in early (-FA)
+
+//----------------------------------------------------------------------
+// NewPrefetchList
+// 	Make an empty list of prefetched frames for a new space.  A frame
+//	is on the list of the space it is charged to, so one set of links
+//	does for all of them.
+//----------------------------------------------------------------------
+
+static FrameList *
+NewPrefetchList()
+{
+	if (prefetchPrev == NULL) {
+		prefetchPrev = new int[NumPhysPages];
+		prefetchNext = new int[NumPhysPages];
+	}
+	return new FrameList(prefetchPrev, prefetchNext);
+}
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -31,60 +59,42 @@
 //AR
 // valid - Set true if page is in physical memory.
 void AddrSpace::setValidity(int vPage, bool valid){
-	// begin code changes by joseph kokenge
-	if (isTwoLevel) {
-		int outerIndex = vPage/innerTableSize;
-
-		int innerIndex = vPage%innerTableSize;	
-
-		outerPageTable[outerIndex][innerIndex].valid = valid;
-	// end code changes by joseph kokenge
-	} else {
-		pageTable[vPage].valid = valid;
-	}
+	getEntry(vPage)->valid = valid;
+	machine->FlushMicroTLB(vPage);	// the simulator may have it cached
+	if (!valid)
+		DropTLBEntry(vPage);	// and so may the TLB
 }
 //dirty - Set if page is modified by machine.
 void AddrSpace::setDirty(int vPage, bool dirty){
-	// begin code changes by joseph kokenge
-	if (isTwoLevel) {
-		int outerIndex = vPage/innerTableSize;
-
-		int innerIndex = vPage%innerTableSize;	
-
-		outerPageTable[outerIndex][innerIndex].dirty = dirty;
-		// end code changes by joseph kokenge
-	} else {
-		
-		pageTable[vPage].dirty = dirty;
-	}
+	getEntry(vPage)->dirty = dirty;
 }
 
-int AddrSpace::getPageNum(int pPage){
-	// begin code changes by joseph kokenge
-	if (isTwoLevel) {
-		for(int i = 0; i < outerTableSize; i++){
-			if (!(outerPageTable[i] == NULL)){
-				for (int j = 0; j < innerTableSize; j++){	
-					if(outerPageTable[i][j].physicalPage == pPage && outerPageTable[i][j].valid)
-						return outerPageTable[i][j].virtualPage;
-				}
-			}
+//----------------------------------------------------------------------
+// AddrSpace::getEntry
+// 	Return the page table entry for a virtual page, or NULL if the
+//	page is outside the address space (or, with a radix table, if
+//	none of the pages near it is in memory, so it has no leaf).
+//----------------------------------------------------------------------
 
-				
-			}
-			return -1;		
-	// end code changes by joseph kokenge		
-	} else {
-		
-		for(int i = 0; i < numPages; i++){
-			if(pageTable[i].physicalPage == pPage && pageTable[i].valid){
-					return pageTable[i].virtualPage;
-			}
-		}
-		return -1;
+TranslationEntry *AddrSpace::getEntry(int vPage){
+	if (vPage < 0 || vPage >= (int) numPages)
+		return NULL;
+	if (isTwoLevel)
+		return radixTable->Lookup(vPage);
+	return &pageTable[vPage];
+}
 
-	}
+//----------------------------------------------------------------------
+// AddrSpace::MakeEntry
+// 	Return the page table entry for a page in the address space that
+//	is being brought into memory, making the radix tables down to it
+//	if they have been freed, or not made yet.
+//----------------------------------------------------------------------
 
+TranslationEntry *AddrSpace::MakeEntry(int vPage){
+	if (isTwoLevel)
+		return radixTable->Make(vPage);
+	return &pageTable[vPage];
 }
 
 
@@ -118,43 +128,60 @@ SwapHeader (NoffHeader *noffH)
 //	only uniprogramming, and we have a single unsegmented page table
 //
 //	"executable" is the file containing the object code to load into memory
+//	"fileName" is its name, to find other spaces running the same program
 //----------------------------------------------------------------------
 
-AddrSpace::AddrSpace(OpenFile *executable, int threadid)
+AddrSpace::AddrSpace(OpenFile *executable, int threadid, char *fileName)
 {
 
-	exeFile = executable;
+	exeFile = executable;	// ours now; we page from it
 	NoffHeader noffH;
 	unsigned int i, size, pAddr, counter;
 	space = false;
+	processId = threadid;
+	resident = charged = 0;
+	prefetchWindow = 1;
+	prefetchHits = 0;
+	lastFaultPage = -1;
+	prefetchedFrames = NewPrefetchList();
+	quota = PFFInitialQuota;
+	lastFault = runTicks = 0;
+	startTicks = stats->userTicks;
+	asid = -1;		// assigned when it first runs
+	nextSpace = allSpaces;
+	allSpaces = this;
 
     executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
     if ((noffH.noffMagic != NOFFMAGIC) &&
 		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
 		SwapHeader(&noffH);
 	ASSERT(noffH.noffMagic == NOFFMAGIC);
+	exeHeader = new NoffHeader;
+	*exeHeader = noffH;
+
+	// Pages wholly inside the code segment can be shared with other
+	// spaces running the program.
+	int textFirst = divRoundUp(noffH.code.virtualAddr, PageSize);
+	int textEnd = (noffH.code.virtualAddr + noffH.code.size) / PageSize;
+	text = textCache->Attach(fileName, textFirst, max(textEnd - textFirst, 0),
+				 this);
 
 	size = noffH.code.size + noffH.initData.size + noffH.uninitData.size + UserStackSize; // we need to increase the size
 	numPages = divRoundUp(size, PageSize);
 	size = numPages * PageSize;
 
-	// Create swap file
-	sprintf(swapFileName, "%i.swap", threadid);
-	//Here, we create a swapFileName as ID.swap using unique thread ID
-	fileSystem->Create(swapFileName, size);
-	printf("\nSWAPFILE CREATION: Swapfile %s has been created.\n",swapFileName);
-	// //Then, we must open it up.
-	swapFile = fileSystem->Open(swapFileName);
+	profile = NULL;
+	if (profiling)		// kept after we're gone, for Halt
+		profile = new Profile(threadid, &noffH, numPages);
 
-	int exeSize = noffH.code.size + noffH.initData.size + noffH.uninitData.size;
-	//This int represents the size of the buffer.
-	char *exeBuff = new char[exeSize];
-	executable->ReadAt(exeBuff, exeSize, sizeof(noffH));
-	swapFile->WriteAt(exeBuff, exeSize, 0);
-
-	// Close to not consume mem
-	delete [] exeBuff; //  code change by joseph kokenge
-	delete swapFile;
+	// Nothing is read yet.  Code and initialized data are read from
+	// the executable when first touched, bss and stack zero-filled
+	// (see LoadPage); a page only gets a swap slot when it is replaced
+	// once it has been dirtied.
+	swapSlot = new int[numPages];
+	for (i = 0; i < numPages; i++)
+		swapSlot[i] = -1;	// nothing in swap
+	printf("\nSWAP: Process %i has %i pages, none in swap yet.\n", threadid, numPages);
 
 	//If we get past the if statement, then there was sufficient space
 	space = true;
@@ -167,14 +194,7 @@ AddrSpace::AddrSpace(OpenFile *executable, int threadid)
 		printf("Initializing Two level Table\n");
 
 
-	    outerPageTable = new TranslationEntry*[outerTableSize];
-
-		for (i = 0; i < outerTableSize; i++) {
-			outerPageTable[i] = NULL;
-
-
-	    }
-
+	    radixTable = new RadixTable(numPages);	// just its root, so far
 
 		//end code by joseph kokenge
 	} else {
@@ -203,192 +223,765 @@ AddrSpace::AddrSpace(OpenFile *executable, int threadid)
 
 
 
-void AddrSpace::HandlePageFault(int addr){
-	int vPage = addr / PageSize;
-	//begin Code changes Joseph Kokenge
-
-	if (isTwoLevel) {
-		//printf("address: %d",addr);
-
-		int outerIndex = vPage/innerTableSize;
+//----------------------------------------------------------------------
+// AddrSpace::AddrSpace
+// 	Make a copy of "parent" for a new process (Fork), without copying
+//	any memory.  The pages it has in memory are mapped into both,
+//	read-only; the first one to write to such a page gets a copy of 
+//	its own (see CopyOnWrite).  The pages it has in swap are shared
+//	by slot, until one of us has to write one back.  Text pages are
+//	mapped again from the text cache when they are first touched.
+//
+//	"parent" is the running space, which is calling Fork
+//	"threadid" is the new process's id
+//----------------------------------------------------------------------
 
-		int innerIndex = vPage%innerTableSize;
+AddrSpace::AddrSpace(AddrSpace *parent, int threadid)
+{
+	TranslationEntry *entry;
+	int vPage;
 
-		//printf("OUTER INDEX: %d\n",outerIndex);
-		//printf("inner INDEX: %d\n",innerIndex);
+	space = false;
+	processId = threadid;
+	resident = charged = 0;
+	prefetchWindow = 1;
+	prefetchHits = 0;
+	lastFaultPage = -1;
+	prefetchedFrames = NewPrefetchList();
+	quota = PFFInitialQuota;
+	lastFault = runTicks = 0;
+	startTicks = stats->userTicks;
+	asid = -1;
+	nextSpace = allSpaces;
+	allSpaces = this;
+
+	exeHeader = new NoffHeader;
+	*exeHeader = *parent->exeHeader;
+	text = parent->text;
+	text->AddUser(this);
+	exeFile = fileSystem->Open(text->Name());	// our own, to close
+	ASSERT(exeFile != NULL);
+	numPages = parent->numPages;
+	profile = NULL;
+	if (profiling)
+		profile = new Profile(threadid, exeHeader, numPages);
+
+	swapSlot = new int[numPages];
+	for (vPage = 0; vPage < (int) numPages; vPage++) {
+		swapSlot[vPage] = parent->swapSlot[vPage];
+		if (swapSlot[vPage] != -1)
+			swapManager->Share(swapSlot[vPage]);
+	}
 
-		if (outerPageTable[outerIndex] == NULL) {
-			outerPageTable[outerIndex] = new TranslationEntry[innerTableSize];
+	// The parent's TLB entries may be writable, or have newer use and
+	// dirty bits; then its pages in memory become read-only, and the
+	// page table, with them, is ours as well.
+	parent->FlushTLB();
+	for (vPage = 0; vPage < (int) numPages; vPage++) {
+		entry = parent->getEntry(vPage);
+		if (entry != NULL && entry->valid
+				&& frameTable[entry->physicalPage].text == NULL)
+			entry->readOnly = TRUE;
+	}
+	machine->FlushMicroTLB();
+	if (isTwoLevel)
+		radixTable = new RadixTable(parent->radixTable);
+	else {
+		pageTable = new TranslationEntry[numPages];
+		for (vPage = 0; vPage < (int) numPages; vPage++)
+			pageTable[vPage] = parent->pageTable[vPage];
+	}
+	for (vPage = 0; vPage < (int) numPages; vPage++) {
+		entry = getEntry(vPage);
+		if (entry == NULL || !entry->valid)
+			continue;
+		if (frameTable[entry->physicalPage].text != NULL) {
+			entry->valid = FALSE;		// MapSharedText will do it
+			entry->physicalPage = -1;
+			if (isTwoLevel)
+				radixTable->Prune(vPage);
+			continue;
+		}
+		frameTable[entry->physicalPage].mapCount++;
+		resident++;
+		stats->numCowShared++;
+	}
+	quota = max(quota, resident);	// room to copy what it shares
+	printf("\nFORK: Process %i shares %i pages in memory with process %i.\n",
+		threadid, resident, parent->processId);
+	space = true;
+}
 
-		    for (int i = 0; i < innerTableSize; i++) {
-				outerPageTable[outerIndex][i].virtualPage = innerTableSize*outerIndex+i;	// for now, virtual page # = phys page #
-				outerPageTable[outerIndex][i].valid = FALSE; //edit AF, setting valid bits to false per request of instructions
-				outerPageTable[outerIndex][i].use = FALSE;
-				outerPageTable[outerIndex][i].dirty = FALSE;
-				outerPageTable[outerIndex][i].readOnly = FALSE;  // if the code segment was entirely on
-		    }
-			printf("made a new page table\n");
+//----------------------------------------------------------------------
+// AddrSpace::HandlePageFault
+// 	Bring in the page holding "addr", which isn't in memory.
+//----------------------------------------------------------------------
 
-		}
+void AddrSpace::HandlePageFault(int addr){
+	int vPage = addr / PageSize;
 
-		//end Code changes Joseph Kokenge
+	// With -H, the radix tables down to the page are made when it is
+	// mapped (see MakeEntry): making them now, before a frame is found
+	// for it, could see them freed again by the eviction.
 
-	}
 	//Begin changes Alec Hebert and Armando Fuentes
-		int pPage = memMap -> Find();
 		printf("PAGE FAULT #%i\n",faultcount);
 		if (extraInput)
 			printf("\nPAGE FAULT: Process %i requests virtual page %i.\n", currentThread -> getID(), vPage);
+		if (MapSharedText(vPage))
+			return;			// no I/O, and no frame needed
 
-		// Something needs to be swapped out
-		// Something needs to be swapped out
-		if (pPage == -1)
-		{
-			// Pick a page to swap out
-			if (repChoice == 1)
-			{ // FIFO
-				pPage = (int)fifo.Remove();
-			}
-			else if (repChoice == 2)
-			{ // RANDOM
-				pPage = (int)(Random() % NumPhysPages);
-
-			}
-			else
-			{ // Demand
-				printf("You chose Demand Paging, not enough pages are available. Due to your choice, nothing will be swapped and this process will terminate.\n");
-				Cleanup();
-			}
-			// Do the roar
-			printf("Swapping out thread %d page %d\n",ipt[pPage]->getID(),pPage);
-			ipt[pPage]->space->SwapOut(pPage);
-		}
+		int pPage = GetFrame(vPage);
 
 		// Swap in
 		LoadPage(vPage, pPage);
 		memMap->Print();
-		// Update queue if we fifo
-		if (repChoice == 1)
+		// Tell the policy what's in the frame now
+		if (replacer != NULL)
 		{
-			fifo.Append((void *)pPage);
+			replacer->PageIn(pPage);
 		}
+		if (faultAround)
+			FaultAround(vPage);
 		//End changes Alec Hebert and Armando Fuentes
 
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::GetFrame
+// 	Find a frame to put our page "vPage" in: a free one if we may
+//	have it, or else one the replacement policy empties for us.
+//----------------------------------------------------------------------
 
+int AddrSpace::GetFrame(int vPage)
+{
+	int pPage = -1;
+	AddrSpace *owner = NULL;	// whose frame to take, if any
+
+	if (cleaner != NULL && memMap->NumClear() < CleanerLowWater)
+		cleaner->Wake();	// so victims will be clean
+	if (localReplacement) {
+		AdjustQuota(vPage);
+		if (charged < quota)
+			pPage = memMap->Find();
+		if (pPage == -1)
+			owner = QuotaDonor();
+	} else
+		pPage = memMap->Find();
+	if (reclaimer != NULL) {	// keep the pool topped up (-FP)
+		if (pPage != -1)
+			stats->numPoolHits++;
+		else
+			stats->numPoolMisses++;
+		reclaimer->Fault();
+	}
 
-void AddrSpace::LoadPage(int vPage, int pPage)
+	// Something needs to be swapped out
+	if (pPage == -1)
+	{
+		// Pick a page to swap out
+		if (replacer != NULL)
+		{
+			pPage = replacer->ChooseVictim(this, vPage, owner);
+		}
+		else
+		{ // Demand
+			printf("You chose Demand Paging, not enough pages are available. Due to your choice, nothing will be swapped and this process will terminate.\n");
+			Cleanup();
+		}
+		// Do the roar
+		printf("Swapping out thread %d page %d\n",frameTable[pPage].space->getID(),pPage);
+		frameTable[pPage].space->SwapOut(pPage);
+	}
+	return pPage;
+}
+
+
+//----------------------------------------------------------------------
+// AddrSpace::AdjustQuota
+// 	On a page fault with per-process frame quotas (-PFF), adjust our
+//	quota by how often we fault, measured in our own running time: 
+//	one more frame if we faulted again soon, one fewer if it has been
+//	a long time.  Frames over a lowered quota are given back, to be
+//	taken by whoever needs them.
+//
+//	"vPage" -- the page being faulted in
+//----------------------------------------------------------------------
+
+void AddrSpace::AdjustQuota(int vPage)
 {
-	printf("pPage: %i, vPage: %i\n", pPage, vPage);
-	//begin Code changes Joseph Kokenge
+	int now = runTicks + stats->userTicks - startTicks;
+	int interval = now - lastFault;
+
+	lastFault = now;
+	if (interval < PFFRaiseTicks) {
+		if (quota < NumPhysPages) {
+			quota++;
+			stats->numQuotaRaises++;
+		}
+	} else if (interval > PFFLowerTicks && quota > PFFMinQuota) {
+		quota--;
+		stats->numQuotaCuts++;
+		while (charged > quota) {
+			int pPage = replacer->ChooseVictim(this, vPage, this);
+
+			SwapOut(pPage);
+			memMap->Clear(pPage);
+		}
+	}
+}
 
-	if (isTwoLevel) {
-		if (extraInput)
-			printf("Swapping in Physical Page %d and Virtual Page %d\n", pPage, vPage); //guessing we are going to need this output
-		int outerIndex = vPage/innerTableSize;
+//----------------------------------------------------------------------
+// AddrSpace::QuotaDonor
+// 	With per-process frame quotas (-PFF), return the space to take a
+//	frame from, when there is no free one we may have: our own, once
+//	we have our quota; otherwise whoever is furthest over theirs.
+//
+//	If nobody is over, the quotas add up to more than memory, and we
+//	take from whoever is closest to theirs; taking our own page
+//	instead could leave us too few frames to finish an instruction.
+//
+//	Quotas count the frames charged to a space, which are the only
+//	ones the replacement policy will take from it: a page shared
+//	after a Fork, or a shared text page, counts against one space.
+//----------------------------------------------------------------------
 
-		int innerIndex = vPage%innerTableSize;	
+AddrSpace *AddrSpace::QuotaDonor()
+{
+	AddrSpace *donor = NULL;
+
+	if (charged >= quota)
+		return this;
+	for (AddrSpace *s = allSpaces; s != NULL; s = s->nextSpace)
+		if (s->charged > 0 && (donor == NULL
+				|| s->charged - s->quota > donor->charged - donor->quota))
+			donor = s;
+	return donor;
+}
+//----------------------------------------------------------------------
+// AddrSpace::Charge
+// 	Charge the frame "pPage" to "space" (NULL if it is being freed),
+//	keeping count of how many each space is charged for.
+//----------------------------------------------------------------------
 
-		outerPageTable[outerIndex][innerIndex].physicalPage = pPage;
-	//end Code changes Joseph Kokenge
+void AddrSpace::Charge(int pPage, AddrSpace *space)
+{
+	if (frameTable[pPage].space != NULL)
+		frameTable[pPage].space->charged--;
+	frameTable[pPage].space = space;
+	if (space != NULL)
+		space->charged++;
+}
 
-	} else {
-		if (extraInput)
-			printf("Swapping in Physical Page %d and Virtual Page %d\n", pPage, vPage); //guessing we are going to need this output
-		pageTable[vPage].physicalPage = pPage;
+//----------------------------------------------------------------------
+// AddrSpace::FaultAround
+// 	After a page fault on "vPage" (-FA), also bring in the next few
+//	pages, as long as they aren't there already and there are free 
+//	frames for them -- we never evict anything to make room.
+//
+//	How many is adapted to how useful it has been: the window doubles
+//	if a page brought in this way has been found to be used since the
+//	last fault, and halves whenever one goes out again unused (see 
+//	EndPrefetch).  The replacement policy may find the use first, 
+//	when it clears use bits.
+//	Once it has shrunk to nothing, two faults on consecutive pages
+//	start it again.
+//----------------------------------------------------------------------
+
+void AddrSpace::FaultAround(int vPage)
+{
+	// which of the pages brought in before have been used since?
+	for (int pPage = prefetchedFrames->First(), next; pPage != -1; pPage = next) {
+		next = prefetchedFrames->Next(pPage);	// it may leave the list
+		SyncTLBEntry(frameTable[pPage].virtualPage);
+		if (getEntry(frameTable[pPage].virtualPage)->use)
+			PrefetchUsed(pPage);
 	}
+	if (prefetchHits > 0)
+		prefetchWindow = min(MaxPrefetch, max(prefetchWindow, 1) * 2);
+	else if (prefetchWindow == 0 && vPage == lastFaultPage + 1)
+		prefetchWindow = 1;
+	prefetchHits = 0;
+	lastFaultPage = vPage;
+
+	for (int v = vPage + 1; v <= vPage + prefetchWindow; v++) {
+		TranslationEntry *entry = getEntry(v);
+		int pPage;
+
+		if (v >= (int) numPages)	// off the end
+			break;
+		if ((entry != NULL && entry->valid) || MapSharedText(v))
+			continue;
+		if (localReplacement && charged >= quota)
+			break;
+		if ((pPage = memMap->Find()) == -1)
+			break;
+		LoadPage(v, pPage);
+		getEntry(v)->use = FALSE;	// so we can tell if it gets used
+		frameTable[pPage].prefetched = TRUE;
+		prefetchedFrames->Append(pPage);
+		if (replacer != NULL)
+			replacer->PageIn(pPage);
+		stats->numPrefetched++;
+	}
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::EndPrefetch
+// 	A frame brought in by FaultAround, and not yet seen to be used,
+//	is being emptied.  Count it as a hit if it was used after all;
+//	otherwise as a waste, and make the window smaller.  The TLB's
+//	bits for it must already have been written back.
+//----------------------------------------------------------------------
+
+void AddrSpace::EndPrefetch(int pPage)
+{
+	if (getEntry(frameTable[pPage].virtualPage)->use)
+		PrefetchUsed(pPage);
+	else {
+		stats->numPrefetchWasted++;
+		prefetchWindow /= 2;
+		frameTable[pPage].prefetched = FALSE;
+		prefetchedFrames->Remove(pPage);
+	}
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PrefetchUsed
+// 	A page that FaultAround brought into "pPage" has been used.
+//----------------------------------------------------------------------
+
+void AddrSpace::PrefetchUsed(int pPage)
+{
+	frameTable[pPage].prefetched = FALSE;
+	prefetchedFrames->Remove(pPage);
+	stats->numPrefetchHits++;
+	prefetchHits++;
+}
+
+void AddrSpace::LoadPage(int vPage, int pPage)
+{
+	printf("pPage: %i, vPage: %i\n", pPage, vPage);
+	if (extraInput)
+		printf("Swapping in Physical Page %d and Virtual Page %d\n", pPage, vPage); //guessing we are going to need this output
+	MakeEntry(vPage)->physicalPage = pPage;
 	
-	ipt[pPage] = currentThread; //AH - put currentThread into ipt slot corresponding to physical page number.
+	Charge(pPage, this);	// so the frame can be taken back from us
+	frameTable[pPage].virtualPage = vPage;
+	frameTable[pPage].prefetched = FALSE;
+	frameTable[pPage].mapCount = 1;
+	resident++;
 
 	setValidity(vPage, true);
 	setDirty(vPage, false);
 	
-	printf("Attempting to open swapfile %s...\n",swapFileName);
-	swapFile = fileSystem->Open(swapFileName);
-	// DONT INCLUDE NOFF SIZE HERE SINCE WE SKIPPED IT WHEN WRITING TO THE SWAPFILE
-	//***
-	
-	swapFile->ReadAt(&(machine->mainMemory[pPage * PageSize]), PageSize, (vPage * PageSize)); //the meat of loadPage
+	if (swapSlot[vPage] != -1)	//the meat of loadPage
+		swapManager->ReadPage(swapSlot[vPage], &(machine->mainMemory[pPage * PageSize]));
+	else if (ReadFromExecutable(vPage, &(machine->mainMemory[pPage * PageSize])))
+		stats->numExeReads++;	// never written: as in the file
+	else				// bss or stack, never written
+		stats->numZeroFills++;
+	machine->InvalidateFrame(pPage);	// old instructions are gone
+
+	frameTable[pPage].text = NULL;
+	if (text != NULL && text->IsText(vPage)) {	// let others map it
+		getEntry(vPage)->readOnly = TRUE;
+		text->SetFrame(vPage, pPage);
+		frameTable[pPage].text = text;
+	}
+}
 
-	delete swapFile;
-	printf("Closing swapfile %s...\n",swapFileName);
+//----------------------------------------------------------------------
+// AddrSpace::MapSharedText
+// 	If "vPage" is a text page that another space running the program
+//	already has in memory, map the same frame, read-only, and return
+//	TRUE; the frame is charged to us from now on, since we are the
+//	latest to use it.  Otherwise return FALSE.
+//----------------------------------------------------------------------
 
+bool AddrSpace::MapSharedText(int vPage)
+{
+	TranslationEntry *entry;
+	int pPage;
+
+	if (text == NULL || !text->IsText(vPage)
+			|| (pPage = text->Frame(vPage)) == -1)
+		return FALSE;
+
+	if (frameTable[pPage].prefetched)	// someone has used it now
+		frameTable[pPage].space->PrefetchUsed(pPage);
+	Charge(pPage, this);
+	entry = MakeEntry(vPage);
+	entry->physicalPage = pPage;
+	entry->readOnly = TRUE;
+	setValidity(vPage, true);
+	setDirty(vPage, false);
+	resident++;
+	stats->numTextShared++;
+	return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Maps, Unmap
+// 	Is "vPage" in memory, in frame "pPage"?  And take "vPage" out of
+//	our page table (and the TLB), without doing anything about the
+//	frame it was in; with -H, its leaf goes too, if it is now empty.
+//----------------------------------------------------------------------
 
+bool AddrSpace::Maps(int vPage, int pPage)
+{
+	TranslationEntry *entry = getEntry(vPage);
 
+	return entry != NULL && entry->valid && entry->physicalPage == pPage;
 }
 
-bool AddrSpace::SwapOut(int pPage)
+void AddrSpace::Unmap(int vPage)
 {
-	printf("swap\n");
-	
-	int vPage = getPageNum(pPage); //Does the page exist?
+	setValidity(vPage, false);
+	setDirty(vPage, false);
+	getEntry(vPage)->physicalPage = -1;
+	resident--;
+	if (isTwoLevel)
+		radixTable->Prune(vPage);
+}
 
-	if (vPage == -1)
-	{
-		printf("ERROR: Could not swap page!\n");
-		return false;
-	}
+//----------------------------------------------------------------------
+// AddrSpace::EvictSharedText
+// 	The shared text page in "pPage", which is charged to us, is being
+//	replaced: unmap it from every space running the program.  Text is
+//	never written, so there is nothing to save.
+//----------------------------------------------------------------------
 
-	
-	//begin Code changes Joseph Kokenge
+void AddrSpace::EvictSharedText(int pPage)
+{
+	SharedText *shared = frameTable[pPage].text;
+	int vPage = frameTable[pPage].virtualPage;
+
+	DropTLBEntry(vPage);	// pick up the TLB's use bit first
+	if (frameTable[pPage].prefetched)
+		EndPrefetch(pPage);
+	if (replacer != NULL)
+		replacer->PageFree(pPage);
+	for (int i = 0; i < shared->NumUsers(); i++)
+		if (shared->User(i)->Maps(vPage, pPage))
+			shared->User(i)->Unmap(vPage);
+	shared->SetFrame(vPage, -1);
+	Charge(pPage, NULL);
+	frameTable[pPage].virtualPage = -1;
+	frameTable[pPage].text = NULL;
+	stats->numEvictions++;
+}
 
-	if (isTwoLevel) {
+//----------------------------------------------------------------------
+// AddrSpace::ReleaseSharedText
+// 	We are going away.  Unmap our shared text pages, and hand the
+//	frames charged to us to another space that has the page mapped,
+//	so they stay in memory for it.  If nobody else has, free them:
+//	a frame is only charged to a space that maps it, since the 
+//	replacement policy and the page cleaner look at that space's
+//	page table entry (and with -H, another space may have none).
+//----------------------------------------------------------------------
 
+void AddrSpace::ReleaseSharedText()
+{
+	for (int vPage = text->FirstPage(); text->IsText(vPage); vPage++) {
+		AddrSpace *heir = NULL;
+		int pPage = text->Frame(vPage);
 
-		int outerIndex = vPage/innerTableSize;
+		if (pPage == -1)
+			continue;
+		if (frameTable[pPage].space == this && frameTable[pPage].prefetched)
+			EndPrefetch(pPage);
+		if (Maps(vPage, pPage))
+			Unmap(vPage);
+		if (frameTable[pPage].space != this)
+			continue;
+
+		for (int i = 0; i < text->NumUsers(); i++) {
+			AddrSpace *user = text->User(i);
+
+			if (user != this && user->Maps(vPage, pPage))
+				heir = user;
+		}
+		if (heir != NULL) {
+			Charge(pPage, heir);
+			continue;
+		}
+		if (replacer != NULL)
+			replacer->PageFree(pPage);
+		memMap->Clear(pPage);
+		text->SetFrame(vPage, -1);
+		Charge(pPage, NULL);
+		frameTable[pPage].virtualPage = -1;
+		frameTable[pPage].text = NULL;
+	}
+	textCache->Detach(text, this);
+	text = NULL;
+}
 
-		int innerIndex = vPage%innerTableSize;	
+//----------------------------------------------------------------------
+// AddrSpace::CopyOnWrite
+// 	A write to "addr" found its page read-only.  If the page is
+//	shared with other processes after a Fork, give us a copy of our
+//	own in a new frame (or, if nobody else maps it any more, just
+//	take the frame), writable, and return TRUE so the write can be
+//	tried again.  Return FALSE if the page really is read-only.
+//----------------------------------------------------------------------
 
-		if (outerPageTable[outerIndex][innerIndex].dirty)
-		{
-			if (extraInput)
-			{
-				printf("Swap out physical page %i from process %i.\n", vPage, ipt[vPage]->getID());
-			}
-			char *pos = machine->mainMemory + pPage * PageSize;
+bool AddrSpace::CopyOnWrite(int addr)
+{
+	int vPage = (unsigned) addr / PageSize;
+	TranslationEntry *entry = getEntry(vPage);
+	int oldFrame, newFrame;
+
+	if (entry == NULL || !entry->valid || !entry->readOnly
+			|| frameTable[entry->physicalPage].text != NULL)
+		return FALSE;
+	DropTLBEntry(vPage);	// its copy is read-only too
+	oldFrame = entry->physicalPage;
+	if (frameTable[oldFrame].mapCount == 1) {	// the others copied it
+		entry->readOnly = FALSE;
+		machine->FlushMicroTLB(vPage);
+		return TRUE;
+	}
 
-			swapFile = fileSystem->Open(swapFileName);
-			swapFile->WriteAt(pos, PageSize, vPage * PageSize);
-			delete swapFile;
-		}
+	frameTable[oldFrame].pinCount++;	// not the one to replace!
+	newFrame = GetFrame(vPage);
+	frameTable[oldFrame].pinCount--;
+	memcpy(machine->mainMemory + newFrame * PageSize,
+	       machine->mainMemory + oldFrame * PageSize, PageSize);
+	frameTable[oldFrame].mapCount--;
+	if (frameTable[oldFrame].space == this) {	// charge it to another
+		if (frameTable[oldFrame].prefetched)
+			PrefetchUsed(oldFrame);
+		Charge(oldFrame, OtherMapper(vPage, oldFrame));
+	}
 
-		setValidity(vPage, false);
-		setDirty(vPage, false);
-		outerPageTable[outerIndex][innerIndex].physicalPage = -1;
-		
-		if (extraInput)
-			printf("Virtual page %i removed.\n", vPage);
+	entry->physicalPage = newFrame;
+	entry->readOnly = FALSE;
+	entry->use = TRUE;
+	entry->dirty = TRUE;	// it's no longer what is in swap
+	Charge(newFrame, this);
+	frameTable[newFrame].virtualPage = vPage;
+	frameTable[newFrame].prefetched = FALSE;
+	frameTable[newFrame].text = NULL;
+	frameTable[newFrame].mapCount = 1;
+	machine->InvalidateFrame(newFrame);
+	machine->FlushMicroTLB(vPage);
+	if (replacer != NULL)
+		replacer->PageIn(newFrame);
+	stats->numCowCopies++;
+	return TRUE;
+}
 
-		return true;
-	
-	//end Code changes Joseph Kokenge
+//----------------------------------------------------------------------
+// AddrSpace::OtherMapper
+// 	Return another address space that has "vPage" mapped to frame
+//	"pPage" -- one sharing it with us after a Fork -- or NULL.
+//----------------------------------------------------------------------
 
-	} else {
+AddrSpace *AddrSpace::OtherMapper(int vPage, int pPage)
+{
+	for (AddrSpace *s = allSpaces; s != NULL; s = s->nextSpace)
+		if (s != this && s->space && s->Maps(vPage, pPage))
+			return s;
+	return NULL;
+}
 
-		if (pageTable[vPage].dirty)
-		{
-			if (extraInput)
-			{
-				printf("Swap out physical page %i from process %i.\n", vPage, ipt[vPage]->getID());
+//----------------------------------------------------------------------
+// AddrSpace::PrivateSlot
+// 	Return a swap slot to write our page "vPage" to: the one it 
+//	already has, unless it has none, or shares it with processes
+//	Forked from us (or we from them), which still need what's in it.
+//----------------------------------------------------------------------
+
+int AddrSpace::PrivateSlot(int vPage)
+{
+	if (swapSlot[vPage] != -1 && swapManager->IsShared(swapSlot[vPage])) {
+		swapManager->Free(swapSlot[vPage]);
+		swapSlot[vPage] = -1;
+	}
+	if (swapSlot[vPage] == -1)
+		swapSlot[vPage] = swapManager->Allocate();
+	return swapSlot[vPage];
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::EvictCopyOnWrite
+// 	The page in "pPage", which is charged to us, is shared with
+//	other processes after a Fork, and is being replaced: unmap it
+//	from all of them.  If any of them has it dirty, it is written
+//	once, to a new slot they all share.
+//----------------------------------------------------------------------
+
+void AddrSpace::EvictCopyOnWrite(int pPage)
+{
+	int vPage = frameTable[pPage].virtualPage;
+	bool dirty = FALSE;
+	int slot = -1;
+	AddrSpace *s;
+
+	for (s = allSpaces; s != NULL; s = s->nextSpace)
+		if (s->space && s->Maps(vPage, pPage)) {
+			s->DropTLBEntry(vPage);	// pick up its dirty bit
+			dirty = dirty || s->getEntry(vPage)->dirty;
+		}
+	if (frameTable[pPage].prefetched)
+		EndPrefetch(pPage);
+	if (replacer != NULL)
+		replacer->PageFree(pPage);
+	if (dirty) {
+		slot = swapManager->Allocate();
+		swapManager->WritePage(slot, machine->mainMemory + pPage * PageSize);
+		stats->numDirtyEvictions++;
+	}
+	for (s = allSpaces; s != NULL; s = s->nextSpace)
+		if (s->space && s->Maps(vPage, pPage)) {
+			if (dirty) {
+				if (s->swapSlot[vPage] != -1)
+					swapManager->Free(s->swapSlot[vPage]);
+				if (s != this)
+					swapManager->Share(slot);
+				s->swapSlot[vPage] = slot;
 			}
-			char *pos = machine->mainMemory + pPage * PageSize;
+			s->Unmap(vPage);
+		}
+	Charge(pPage, NULL);
+	frameTable[pPage].virtualPage = -1;
+	frameTable[pPage].mapCount = 0;
+	stats->numEvictions++;
+}
 
-			swapFile = fileSystem->Open(swapFileName);
-			swapFile->WriteAt(pos, PageSize, vPage * PageSize);
-			delete swapFile;
+//----------------------------------------------------------------------
+// AddrSpace::ReleaseCopyOnWrite
+// 	We are going away.  Unmap the pages we still share with other
+//	processes after a Fork, handing the ones charged to us to one of
+//	them; the rest of our frames are ours alone, to be freed.
+//----------------------------------------------------------------------
+
+void AddrSpace::ReleaseCopyOnWrite()
+{
+	for (int vPage = 0; vPage < (int) numPages; vPage++) {
+		TranslationEntry *entry = getEntry(vPage);
+		int pPage;
+
+		if (entry == NULL || !entry->valid)
+			continue;
+		pPage = entry->physicalPage;
+		if (frameTable[pPage].text != NULL || frameTable[pPage].mapCount < 2)
+			continue;
+		if (frameTable[pPage].space == this) {
+			if (frameTable[pPage].prefetched)
+				EndPrefetch(pPage);
+			Charge(pPage, OtherMapper(vPage, pPage));
 		}
+		frameTable[pPage].mapCount--;
+		Unmap(vPage);
+	}
+}
 
-		setValidity(vPage, false);
-		setDirty(vPage, false);
-		pageTable[vPage].physicalPage = -1;
-		if (extraInput)
-			printf("Virtual page %i removed.\n", vPage);
+//----------------------------------------------------------------------
+// AddrSpace::ReadFromExecutable
+// 	Fill "into" with virtual page "vPage" as the program starts out:
+//	whatever code and initialized data fall on the page are read 
+//	from the executable, at their place in the file, and the rest
+//	is zeroed.  Return FALSE if none of the page is in the file.
+//----------------------------------------------------------------------
+
+bool AddrSpace::ReadFromExecutable(int vPage, char *into)
+{
+	Segment *segments[2] = { &exeHeader->code, &exeHeader->initData };
+	int pageStart = vPage * PageSize;
+	bool inFile = FALSE;
+
+	memset(into, 0, PageSize);
+	for (int i = 0; i < 2; i++) {
+		Segment *seg = segments[i];
+		int from = max(pageStart, seg->virtualAddr);
+		int to = min(pageStart + PageSize, seg->virtualAddr + seg->size);
+
+		if (from < to) {
+			exeFile->ReadAt(into + (from - pageStart), to - from,
+					seg->inFileAddr + (from - seg->virtualAddr));
+			inFile = TRUE;
+		}
+	}
+	return inFile;
+}
 
+bool AddrSpace::SwapOut(int pPage)
+{
+	printf("swap\n");
+	
+	int vPage = frameTable[pPage].virtualPage; //Does the page exist?
+
+	if (frameTable[pPage].space != this || vPage == -1)
+	{
+		printf("ERROR: Could not swap page!\n");
+		return false;
+	}
+	if (frameTable[pPage].text != NULL) {
+		EvictSharedText(pPage);
+		return true;
+	}
+	if (frameTable[pPage].mapCount > 1) {
+		EvictCopyOnWrite(pPage);
 		return true;
 	}
+	DropTLBEntry(vPage);	// pick up the TLB's dirty bit first
+	if (frameTable[pPage].prefetched)
+		EndPrefetch(pPage);
+	if (replacer != NULL)
+		replacer->PageFree(pPage);
+	Charge(pPage, NULL);
+	frameTable[pPage].virtualPage = -1;
+	resident--;
+	stats->numEvictions++;
+
+	if (getEntry(vPage)->dirty)
+	{
+		if (extraInput)
+		{
+			printf("Swap out physical page %i from process %i.\n", vPage, processId);
+		}
+		char *pos = machine->mainMemory + pPage * PageSize;
+
+		swapManager->WritePage(PrivateSlot(vPage), pos);
+		stats->numDirtyEvictions++;
+	}
 
+	setValidity(vPage, false);
+	setDirty(vPage, false);
+	getEntry(vPage)->physicalPage = -1;
+	if (isTwoLevel)
+		radixTable->Prune(vPage);	// its leaf may be empty now
+	if (extraInput)
+		printf("Virtual page %i removed.\n", vPage);
+
+	return true;
 }
+//----------------------------------------------------------------------
+// AddrSpace::CleanPage
+// 	Write the dirty page in "pPage" to swap, and mark it clean, but
+//	leave it in memory; used by the page cleaner (-CL).  The frame is
+//	pinned while it is written.
+//----------------------------------------------------------------------
+
+void AddrSpace::CleanPage(int pPage)
+{
+	int vPage = frameTable[pPage].virtualPage;
+	TranslationEntry *entry;
+
+	DropTLBEntry(vPage);	// or its dirty bit would come back
+	entry = getEntry(vPage);
+
+	frameTable[pPage].pinCount++;
+	entry->dirty = FALSE;	// a store during the write dirties it again
+	swapManager->WritePage(PrivateSlot(vPage), machine->mainMemory + pPage * PageSize);
+	frameTable[pPage].pinCount--;
+	stats->numPagesCleaned++;
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
 // 	Dealloate an address space.  Nothing for now!
@@ -399,6 +992,24 @@ bool AddrSpace::SwapOut(int pPage)
 
 AddrSpace::~AddrSpace()
 {
+	FlushTLB();		// before the page tables go
+	if (asid >= 0)
+		asidOwner[asid] = NULL;
+	for (int i = 0; i < (int) numPages; i++)
+		if (swapSlot[i] != -1)
+			swapManager->Free(swapSlot[i]);
+	delete [] swapSlot;
+	delete exeHeader;
+	delete exeFile;		// close the executable
+	if (text != NULL)
+		ReleaseSharedText();	// before the page tables go
+	if (space)
+		ReleaseCopyOnWrite();
+	for (AddrSpace **prev = &allSpaces; *prev != NULL; prev = &(*prev)->nextSpace)
+		if (*prev == this) {
+			*prev = nextSpace;
+			break;
+		}
 
 	// Only clear the memory if it was set to begin with
 	// which in turn only happens after space is set to true
@@ -408,26 +1019,31 @@ AddrSpace::~AddrSpace()
 		if (isTwoLevel) {
 			//delete here
 			//FROM SHAH it involves deleting your pointers of pagetable and clearing the bitMap used by the process.
-			for(int i = 0; i < outerTableSize; i++){
-				if (!(outerPageTable[i] == NULL)){
-					for (int j = 0; j < innerTableSize; j++){	
-						if(outerPageTable[i][j].valid){
-							memMap->Clear(outerPageTable[i][j].physicalPage);
-							ipt[outerPageTable[i][j].physicalPage] = NULL;
-						}
-					}
-					delete [] outerPageTable[i];
+			for(int i = 0; i < (int) numPages; i++){
+				TranslationEntry *entry = radixTable->Lookup(i);
+
+				if (entry != NULL && entry->valid){
+					memMap->Clear(entry->physicalPage);
+					if (frameTable[entry->physicalPage].prefetched)
+						EndPrefetch(entry->physicalPage);
+					if (replacer != NULL)
+						replacer->PageFree(entry->physicalPage);
+					Charge(entry->physicalPage, NULL);
 				}
 			}
-			delete [] outerPageTable;
+			delete radixTable;
 			//end Code changes Joseph Kokenge
 
 		}
 		else {
-			for(int i = 0; i < numPages; i++)	// We need an offset of startPage + numPages for clearing.
+			for(int i = 0; i < (int) numPages; i++)	// We need an offset of startPage + numPages for clearing.
 				if(pageTable[i].valid){
 					memMap->Clear(pageTable[i].physicalPage);
-					ipt[pageTable[i].physicalPage] = NULL;
+					if (frameTable[pageTable[i].physicalPage].prefetched)
+						EndPrefetch(pageTable[i].physicalPage);
+					if (replacer != NULL)
+						replacer->PageFree(pageTable[i].physicalPage);
+					Charge(pageTable[i].physicalPage, NULL);
 				}
 				delete [] pageTable;
 
@@ -436,10 +1052,11 @@ AddrSpace::~AddrSpace()
 
 
 		}
-		//		if (!fileSystem->Remove(swapFileName))
-		//			printf("failed to delete swap file\n");
+
 		memMap->Print();
 	}
+	ASSERT(charged == 0);		// or a frame would point at us still
+	delete prefetchedFrames;
 }
 
 //----------------------------------------------------------------------
@@ -483,11 +1100,23 @@ void AddrSpace::InitRegisters()
 // 	On a context switch, save any machine state, specific
 //	to this address space, that needs saving.
 //
-//	For now, nothing!
+//	For now, how long we ran, and the TLB's use and dirty bits -- 
+//	unless its entries are tagged with our ASID, in which case they
+//	can stay where they are until we run again.
 //----------------------------------------------------------------------
 
 void AddrSpace::SaveState()
 {
+	runTicks += stats->userTicks - startTicks;
+	startTicks = stats->userTicks;		// so a second save adds nothing
+	if (machine->tlb == NULL)
+		return;
+	if (asidTagging)
+		stats->numTLBFlushesAvoided++;
+	else {
+		FlushTLB();
+		stats->numTLBFlushes++;
+	}
 }
 
 //----------------------------------------------------------------------
@@ -495,22 +1124,224 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table, or 
+//	with tagged TLB entries, which of them are ours.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState()
 {
+	startTicks = stats->userTicks;
 
 	//begin Code changes Joseph Kokenge
 
 	if (isTwoLevel) {
-		machine->outerPageTable = outerPageTable;
-		machine->twoLevelPageTableSize = totalSize;
+		machine->radixTable = radixTable;
 	//end Code changes Joseph Kokenge
 
-	} else {
-		machine->pageTable = pageTable;
+	} else if (machine->tlb == NULL) {	// with a TLB, the machine
+		machine->pageTable = pageTable;	// never sees the page table
 		machine->pageTableSize = numPages;
 	}
+	if (machine->tlb != NULL && asidTagging) {
+		if (asid < 0)
+			TakeASID();
+		machine->tlbAsid = asid;
+	}
+	machine->FlushMicroTLB();
+	machine->profile = profile;	// cached lookups were for the old table
+
+}
+
+//----------------------------------------------------------------------
+// TLBEntryOwner
+// 	Return the address space a valid TLB entry was loaded from.
+//	Untagged, the TLB only ever holds the running space's pages.
+//----------------------------------------------------------------------
+
+static AddrSpace *
+TLBEntryOwner(TranslationEntry *tlbEntry)
+{
+	if (asidTagging)
+		return asidOwner[tlbEntry->asid];
+	return currentThread->space;
+}
+
+//----------------------------------------------------------------------
+// ReleaseTLBEntry
+// 	Copy the use and dirty bits of a TLB entry back to the page
+//	table entry it was loaded from, and invalidate it.
+//----------------------------------------------------------------------
+
+static void
+ReleaseTLBEntry(TranslationEntry *tlbEntry)
+{
+	TranslationEntry *entry = 
+		TLBEntryOwner(tlbEntry)->getEntry(tlbEntry->virtualPage);
+
+	if (entry != NULL) {
+		entry->use = entry->use || tlbEntry->use;
+		entry->dirty = entry->dirty || tlbEntry->dirty;
+	}
+	tlbEntry->valid = FALSE;
+}
+
+//----------------------------------------------------------------------
+// ChooseTLBSlot
+// 	Pick the TLB entry to refill: a free one if there is one, else
+//	one at random (-TLB 1) or the next one the clock hand finds that
+//	hasn't been used since it last came round (-TLB 2).
+//----------------------------------------------------------------------
+
+static int tlbHand = 0;		// next TLB entry for the clock to look at
+
+static int
+ChooseTLBSlot()
+{
+	TranslationEntry *tlb = machine->tlb;
+	int i;
+
+	for (i = 0; i < machine->tlbSize; i++)
+		if (!tlb[i].valid)
+			return i;
+
+	if (tlbChoice != 2)
+		return Random() % machine->tlbSize;
+
+	for (;;) {
+		i = tlbHand;
+		tlbHand = (tlbHand + 1) % machine->tlbSize;
+		if (!tlb[i].use)
+			return i;
+		TLBEntryOwner(&tlb[i])->getEntry(tlb[i].virtualPage)->use
+			= TRUE;			// keep it for page replacement
+		tlb[i].use = FALSE;
+	}
+}
 
+//----------------------------------------------------------------------
+// AddrSpace::HandleTLBMiss
+// 	Called on a PageFaultException when translating through a TLB.
+//	If the page is in memory, load its translation into the TLB, 
+//	replacing an older entry; the instruction then re-executes.
+//
+//	Returns NoException if the TLB was refilled, PageFaultException
+//	if the page has to be brought in first (it will miss again after
+//	that), or AddressErrorException if "addr" is outside the space.
+//----------------------------------------------------------------------
+
+ExceptionType AddrSpace::HandleTLBMiss(int addr)
+{
+	int vPage = (unsigned) addr / PageSize;
+	TranslationEntry *entry, *tlbEntry;
+
+	if (vPage >= (int) numPages)
+		return AddressErrorException;
+	entry = getEntry(vPage);
+	if (entry == NULL || !entry->valid)
+		return PageFaultException;
+
+	tlbEntry = &machine->tlb[ChooseTLBSlot()];
+	if (tlbEntry->valid)
+		ReleaseTLBEntry(tlbEntry);
+	tlbEntry->asid = machine->tlbAsid;
+	tlbEntry->virtualPage = vPage;
+	tlbEntry->physicalPage = entry->physicalPage;
+	tlbEntry->readOnly = entry->readOnly;
+	tlbEntry->use = FALSE;
+	tlbEntry->dirty = FALSE;
+	tlbEntry->valid = TRUE;
+	return NoException;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::DropTLBEntry
+// 	The page table entry for "vPage" is about to change, so write
+//	back and invalidate its TLB entry, if it has one.
+//----------------------------------------------------------------------
+
+void AddrSpace::DropTLBEntry(int vPage)
+{
+	if (machine->tlb == NULL)
+		return;
+	for (int i = 0; i < machine->tlbSize; i++)
+		if (machine->tlb[i].valid && machine->tlb[i].virtualPage == vPage
+				&& OwnsTLBEntry(&machine->tlb[i]))
+			ReleaseTLBEntry(&machine->tlb[i]);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::SyncTLBEntry
+// 	Copy the use and dirty bits of "vPage"'s TLB entry, if it has
+//	one, back to the page table, leaving the entry loaded.  Its use
+//	bit is cleared, so that it shows only later references.
+//----------------------------------------------------------------------
+
+void AddrSpace::SyncTLBEntry(int vPage)
+{
+	if (machine->tlb == NULL)
+		return;
+	for (int i = 0; i < machine->tlbSize; i++) {
+		TranslationEntry *tlbEntry = &machine->tlb[i];
+
+		if (tlbEntry->valid && tlbEntry->virtualPage == vPage
+				&& OwnsTLBEntry(tlbEntry)) {
+			TranslationEntry *entry = getEntry(vPage);
+
+			entry->use = entry->use || tlbEntry->use;
+			entry->dirty = entry->dirty || tlbEntry->dirty;
+			tlbEntry->use = FALSE;
+		}
+	}
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FlushTLB
+// 	Write back and invalidate every TLB entry of this address space.
+//----------------------------------------------------------------------
+
+void AddrSpace::FlushTLB()
+{
+	if (machine->tlb == NULL)
+		return;
+	for (int i = 0; i < machine->tlbSize; i++)
+		if (machine->tlb[i].valid && OwnsTLBEntry(&machine->tlb[i]))
+			ReleaseTLBEntry(&machine->tlb[i]);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::OwnsTLBEntry
+// 	Is a valid TLB entry one of ours?  Tagged, it has our ASID; 
+//	otherwise the TLB only holds the running space's pages.
+//----------------------------------------------------------------------
+
+bool AddrSpace::OwnsTLBEntry(TranslationEntry *tlbEntry)
+{
+	if (asidTagging)
+		return tlbEntry->asid == asid;
+	return currentThread->space == this;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::TakeASID
+// 	Pick an unused address space id to tag our TLB entries with.  If
+//	all NumASIDs are in use, take one back from another space, 
+//	flushing its entries; it will get a new one when it next runs.
+//----------------------------------------------------------------------
+
+void AddrSpace::TakeASID()
+{
+	int i;
+
+	for (i = 0; i < NumASIDs; i++)
+		if (asidOwner[i] == NULL)
+			break;
+	if (i == NumASIDs) {
+		i = asidHand;
+		asidHand = (asidHand + 1) % NumASIDs;
+		asidOwner[i]->FlushTLB();
+		asidOwner[i]->asid = -1;
+		stats->numTLBFlushes++;
+	}
+	asid = i;
+	asidOwner[i] = this;
 }
@@ -17,17 +17,39 @@
 #include "filesys.h"
 #include "swap.h"
 
+struct noffHeader;			// see noff.h
+class SharedText;			// see textcache.h
+class FrameList;			// see replace.h
+
 #define UserStackSize		1024 	// increase this as necessary!
 
+// With per-process frame quotas (-PFF), a space's quota is raised when
+// it faults again within PFFRaiseTicks of its own running time, and
+// lowered when it has run PFFLowerTicks without a fault.
+
+#define PFFRaiseTicks		2000
+#define PFFLowerTicks		20000
+#define PFFInitialQuota		4
+#define PFFMinQuota		2
+
+#define MaxPrefetch		8	// pages brought in after a fault (-FA)
+
 
 class AddrSpace {
   public:
     
 
     
-    AddrSpace(OpenFile *executable, int threadid);	// Create an address space,
+    AddrSpace(OpenFile *executable, int threadid, char *fileName);
+					// Create an address space,
 					// initializing it with the program
-					// stored in the file "executable"
+					// stored in the file "executable";
+					// it keeps the file, and closes it.
+					// Spaces made from the same
+					// "fileName" share text pages
+    AddrSpace(AddrSpace *parent, int threadid);
+					// Make a copy of "parent" (Fork),
+					// sharing its pages copy-on-write
     ~AddrSpace();			// De-allocate an address space
 
     void InitRegisters();		// Initialize user-level CPU registers,
@@ -41,27 +63,91 @@ class AddrSpace {
 
     void LoadPage(int vPage, int pPage);
     void HandlePageFault(int addr);
+    bool CopyOnWrite(int addr);		// on a write to a read-only page,
+					// copy it if it is shared after a
+					// Fork; FALSE if it is really
+					// read-only
     bool SwapOut(int pPage);
     bool SwapIn(int vPage, int pPage); 
 
-    int getPageNum(int pPage);
-    
-    // begin code changes by joseph kokenge
-    static const int outerTableSize = 16;
-    static const int innerTableSize = 16;
-    static const int totalSize = outerTableSize * innerTableSize;
-  // end code changes by joseph kokenge
+    int getID() { return processId; }	// the process it belongs to
+    TranslationEntry *getEntry(int vPage);	// page table entry for
+					// vPage, or NULL if there isn't one
+    TranslationEntry *MakeEntry(int vPage);	// ... making the radix
+					// tables to hold it if need be
+
+    ExceptionType HandleTLBMiss(int addr);	// refill the TLB from
+					// the page table
+    void DropTLBEntry(int vPage);	// write back and forget vPage's
+					// TLB entry, if it has one
+    void FlushTLB();			// ... and all of this space's entries
+    void SyncTLBEntry(int vPage);	// write back its use and dirty
+					// bits, but keep it
+    void PrefetchUsed(int pPage);	// a page brought in early has
+					// turned out to be used (-FA)
+    void CleanPage(int pPage);		// write back a dirty page, but
+					// keep it (-CL)
 
     //Swap *swap;
     unsigned int numPages;		// Number of pages in the virtual 
     //end AR
   private:
+    int processId;			// id of the process using the space
+    AddrSpace *nextSpace;		// on the list of all address spaces
+
+    int GetFrame(int vPage);		// a frame to bring vPage into
+    int PrivateSlot(int vPage);		// a swap slot to write vPage to,
+					// not shared with anyone
+    AddrSpace *OtherMapper(int vPage, int pPage);
+					// another space with vPage in pPage
+    void EvictCopyOnWrite(int pPage);	// unmap a page shared after a Fork
+					// from everyone
+    void ReleaseCopyOnWrite();		// give up those pages of ours
+
+    void AdjustQuota(int vPage);	// page fault frequency (-PFF)
+    AddrSpace *QuotaDonor();		// whose frame to take
+    int resident;			// frames holding our pages
+    int charged;			// ... and of them, those charged to us
+    static void Charge(int pPage, AddrSpace *space);
+					// charge a frame to "space"
+    int quota;				// frames we may be charged for (-PFF)
+    int lastFault;			// runTicks at our last page fault
+    int runTicks;			// user ticks we ran before the
+					// last context switch
+    int startTicks;			// stats->userTicks when we last
+					// started running
+
+    void FaultAround(int vPage);	// bring in the pages after vPage
+    void EndPrefetch(int pPage);	// see if one of those was used
+    int prefetchWindow;			// how many to bring in (-FA)
+    int prefetchHits;			// of them, used since our last fault
+    int lastFaultPage;			// vPage of our last page fault
+    FrameList *prefetchedFrames;	// frames charged to us that were
+					// brought in early, not yet used
+    bool OwnsTLBEntry(TranslationEntry *tlbEntry);
+    void TakeASID();			// get an ASID to tag TLB entries with
+    int asid;				// that ASID, or -1 if none (-ASID)
+    Profile *profile;			// its instruction counts (-P), or NULL
     
-    OpenFile *exeFile;
-    OpenFile *swapFile;
+    OpenFile *exeFile;			// the program, paged in from here
+    struct noffHeader *exeHeader;	// where its segments are in it
+    bool ReadFromExecutable(int vPage, char *into);
+					// a page as the program starts out
+
+    SharedText *text;			// text pages shared with other
+					// spaces running the program
+    bool MapSharedText(int vPage);	// map a copy someone else has in
+					// memory, if there is one
+    void EvictSharedText(int pPage);	// unmap it from everyone
+    void ReleaseSharedText();		// hand our text frames on, or free
+					// them if nobody else needs them
+    bool Maps(int vPage, int pPage);	// is "vPage" mapped to "pPage"?
+    void Unmap(int vPage);		// take a page out of our page table
+    int *swapSlot;			// swap slot holding each virtual page,
+					// or -1 if it has never been written
     
     
-    TranslationEntry **outerPageTable; // code changes by joseph kokenge
+    RadixTable *radixTable;		// instead of pageTable, with -H
     
     
 
@@ -72,7 +158,32 @@ class AddrSpace {
 	unsigned int startPage;		//Page number that the program starts at
   							//in physical memory
 	bool space;		//Boolean to remember if there was enough space or not
-  char swapFileName[12];
+};
+
+// One entry of the frame table, which says what is in each page of 
+// physical memory.  Indexed by physical page number.
+
+class FrameEntry {
+  public:
+    FrameEntry() { space = NULL; virtualPage = -1; pinCount = 0;
+		   policyInfo = 0; prefetched = FALSE; text = NULL;
+		   mapCount = 0; }
+
+    AddrSpace *space;			// address space the frame is mapped 
+					// into, or NULL if free or kernel-owned;
+					// if it is shared, the one it is
+					// charged to
+    int virtualPage;			// which of its pages is here
+    int pinCount;			// if non-zero, the frame must not be
+					// picked for replacement
+    int policyInfo;			// kept by the replacement policy
+    bool prefetched;			// brought in by fault-around (-FA),
+					// and not yet seen to be used
+    SharedText *text;			// the program whose text page this
+					// is, shared by its spaces, or NULL
+    int mapCount;			// for other pages, how many spaces
+					// map it: more than one after a Fork,
+					// until they write to it
 };
 
 #endif // ADDRSPACE_H
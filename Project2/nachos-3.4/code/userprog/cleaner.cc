@@ -0,0 +1,124 @@
+// cleaner.cc
+//	Routines for the page cleaner thread (-CL).  See cleaner.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "addrspace.h"
+#include "cleaner.h"
+
+//----------------------------------------------------------------------
+// CleanerThread
+// 	The page cleaner's thread: wait to be woken, write back a batch
+//	of dirty pages, and go back to sleep.
+//----------------------------------------------------------------------
+
+static void
+CleanerThread(int arg)
+{
+    PageCleaner *self = (PageCleaner *) arg;
+
+    for (;;)
+	self->Clean();
+}
+
+//----------------------------------------------------------------------
+// PageCleaner::PageCleaner
+// 	Fork the cleaner thread; it goes to sleep straight away.
+//----------------------------------------------------------------------
+
+PageCleaner::PageCleaner()
+{
+    thread = new Thread("page cleaner");
+    asleep = woken = FALSE;
+    lastRun = 0;
+    hand = 0;
+    thread->Fork(CleanerThread, (int) this);
+}
+
+PageCleaner::~PageCleaner()
+{
+}
+
+//----------------------------------------------------------------------
+// PageCleaner::Wake
+// 	Let the cleaner run, next time there is a context switch, unless
+//	it ran less than CleanerMinGap ticks ago; when memory is tight,
+//	every fault would otherwise wake it, and it would spend its time
+//	writing out pages that are about to be dirtied again.
+//----------------------------------------------------------------------
+
+void
+PageCleaner::Wake()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (!woken && stats->totalTicks - lastRun >= CleanerMinGap) {
+	woken = TRUE;
+	if (asleep) {
+	    asleep = FALSE;
+	    scheduler->ReadyToRunFirst(thread);
+	}
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// PageCleaner::Tick
+// 	Wake the cleaner if it hasn't run for CleanerPeriod ticks.
+//	Called by the timer interrupt handler, which should make the
+//	interrupted thread yield if we return TRUE, so it gets to run.
+//----------------------------------------------------------------------
+
+bool
+PageCleaner::Tick()
+{
+    if (stats->totalTicks - lastRun >= CleanerPeriod)
+	Wake();
+    return woken;
+}
+
+//----------------------------------------------------------------------
+// PageCleaner::Clean
+// 	Wait until woken, then sweep the frames for pages that are dirty
+//	and not recently used, and write up to CleanerBatch of them to 
+//	swap.  Whether a page has been used recently is up to the
+//	replacement policy; use bits are only looked at, not cleared.
+//----------------------------------------------------------------------
+
+void
+PageCleaner::Clean()
+{
+    int written = 0;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    while (!woken) {
+	asleep = TRUE;
+	currentThread->Sleep();
+    }
+    woken = FALSE;
+    (void) interrupt->SetLevel(oldLevel);
+    stats->numCleanerRuns++;
+
+    for (int n = 0; n < NumPhysPages && written < CleanerBatch; n++) {
+	int pPage = hand;
+	AddrSpace *owner = frameTable[pPage].space;
+	TranslationEntry *entry;
+
+	hand = (hand + 1) % NumPhysPages;
+	if (owner == NULL || frameTable[pPage].pinCount > 0
+		|| frameTable[pPage].mapCount > 1)	// shared since a Fork
+	    continue;
+	owner->SyncTLBEntry(frameTable[pPage].virtualPage);
+	entry = owner->getEntry(frameTable[pPage].virtualPage);
+	if (entry->dirty && !(replacer != NULL ? replacer->RecentlyUsed(pPage)
+			      : entry->use)) {
+	    owner->CleanPage(pPage);
+	    written++;
+	}
+    }
+    lastRun = stats->totalTicks;
+}
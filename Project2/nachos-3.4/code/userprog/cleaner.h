@@ -0,0 +1,57 @@
+// cleaner.h
+//	Data structures for the page cleaner: a kernel thread that writes
+//	dirty pages to swap ahead of time (-CL), so that when one of them
+//	is picked for replacement it is already clean, and the page fault
+//	doesn't have to wait for a write as well as a read.
+//
+//	The cleaner sleeps until it is woken, either by the timer every
+//	CleanerPeriod ticks, or by a page fault that finds fewer than
+//	CleanerLowWater free frames (but not within CleanerMinGap ticks
+//	of its last run).  Each time, it writes at most CleanerBatch
+//	pages, choosing dirty ones that haven't been used lately; the
+//	pages stay where they are.
+//
+//	When woken, the cleaner goes to the front of the ready list, and
+//	a thread that the timer makes stand aside for it runs again as
+//	soon as it is done, so the cleaner doesn't turn into a time slice
+//	for user programs.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CLEANER_H
+#define CLEANER_H
+
+#include "copyright.h"
+#include "thread.h"
+
+#define CleanerPeriod	5000	// ticks between runs, at least
+#define CleanerLowWater	(NumPhysPages / 8)	// wake early below this
+						// many free frames
+#define CleanerMinGap	1000	// ticks between runs woken by faults
+#define CleanerBatch	4	// pages written per run, at most
+
+class PageCleaner {
+  public:
+    PageCleaner();			// Start the cleaner thread
+    ~PageCleaner();
+
+    void Wake();			// Have it run soon, if it isn't
+					// about to already and didn't just
+    bool Tick();			// Called on timer interrupts; wakes
+					// it if it is time, and returns TRUE
+					// if it is waiting to run
+
+    void Clean();			// Write back a batch; the body of
+					// the thread's loop
+
+  private:
+    Thread *thread;			// the cleaner thread
+    bool asleep;			// is it waiting to be woken?
+    bool woken;				// woken, but hasn't run yet
+    int lastRun;			// totalTicks when it last ran
+    int hand;				// next frame to look at
+};
+
+#endif // CLEANER_H
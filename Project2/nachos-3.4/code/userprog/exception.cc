@@ -27,6 +27,7 @@
 #include "system.h"
 #include "syscall.h"
 #include "addrspace.h"   // FA98
+#include "usercopy.h"
 #include "sysdep.h"   // FA98
 #include "noff.h"
 
@@ -96,6 +97,48 @@ void processCreator(int arg)	// Used when a process first actually runs, not whe
     ASSERT(FALSE);			// machine->Run never returns;
  }
 
+//----------------------------------------------------------------------
+// forkedProcess
+// 	Start a process made by Fork, in its copy of its parent's address
+//	space.  "arg" points to the registers it starts with, which we
+//	delete once they are loaded.
+//----------------------------------------------------------------------
+
+void forkedProcess(int arg)
+{
+	int *registers = (int *) arg;
+
+	for (int r = 0; r < NumTotalRegs; r++)
+		machine->WriteRegister(r, registers[r]);
+	delete [] registers;
+	currentThread->space->RestoreState();	// load page table register
+
+	if (threadToBeDestroyed != NULL){
+		delete threadToBeDestroyed;
+		threadToBeDestroyed = NULL;
+	}
+
+	machine->Run();			// jump to the user progam
+	ASSERT(FALSE);			// machine->Run never returns;
+}
+
+//----------------------------------------------------------------------
+// EndProcess
+// 	The running process is done, by Exit or by an exception it can't
+//	go on from.  Delete its address space and finish its thread; the
+//	space pointer is cleared in between, so the switch away from the
+//	thread doesn't save the state of a deleted space.
+//----------------------------------------------------------------------
+
+static void
+EndProcess()
+{
+	if (currentThread->space != NULL)
+		delete currentThread->space;
+	currentThread->space = NULL;
+	currentThread->Finish();
+}
+
 void
 ExceptionHandler(ExceptionType which)
 {
@@ -105,7 +148,7 @@ ExceptionHandler(ExceptionType which)
 	int arg2 = machine->ReadRegister(5);
 	int arg3 = machine->ReadRegister(6);
 	int Result;
-	int i, j;
+	int j;
 	char *ch = new char [500];
 
 	switch ( which )
@@ -141,16 +184,8 @@ ExceptionHandler(ExceptionType which)
 			break;
 
 		case SC_Write :
-			for (j = 0; ; j++) {
-				if(!machine->ReadMem((arg1+j), 1, &i))
-					j=j-1;
-				else{
-					ch[j] = (char) i;
-					if (ch[j] == '\0') 
-						break;
-				}
-			}
-			if (j == 0){
+			j = CopyInString(arg1, ch, 500);
+			if (j <= 0){
 				printf("\nWrite 0 byte.\n");
 				// SExit(1);
 			} else {
@@ -171,16 +206,12 @@ ExceptionHandler(ExceptionType which)
 				for(int m = 0; m < 100; m++)
 					filename[m] = NULL;
 
-				// Free up allocation space and get the file name
-				if(!machine->ReadMem(fileAddress,1,&j))return;
-				i = 0;
-
-				while(j != 0)
+				// Get the file name
+				if (CopyInString(fileAddress, filename, 100) < 0)
 				{
-					filename[i]=(char)j;
-					fileAddress += 1;
-					i++;
-					if(!machine->ReadMem(fileAddress,1,&j))return;
+					printf("Bad file name address %d\n", fileAddress);
+					delete [] filename;
+					break;
 				}
 				// Open File
 				OpenFile *executable = fileSystem->Open(filename);
@@ -188,20 +219,20 @@ ExceptionHandler(ExceptionType which)
 				if (executable == NULL) 
 				{
 					printf("Unable to open file %s\n", filename);
-					delete filename;
+					delete [] filename;
 					break;
 				}
 
 				// Calculate needed memory space
 				AddrSpace *space;
-				space = new AddrSpace(executable, threadID);
-				delete executable;
+				space = new AddrSpace(executable, threadID, filename);
+					// which keeps the executable open
 				// Do we have enough space?
 				if(!currentThread->killNewChild)	// If so...
 				{
 					//edit AF, made the Thread name match the File Name. Removed the delete filename; that will be done in exit
 					Thread* execThread = new Thread("Wubba", filename);	// Make a new thread for the process.
-					delete filename;
+					delete [] filename;
 					execThread->space = space;	// Set the address space to the new space.
 					execThread->setID(threadID);	// Set the unique thread ID
 					activeThreads->Append(execThread);	// Put it on the active list.
@@ -252,21 +283,43 @@ ExceptionHandler(ExceptionType which)
 				else
 					printf("ERROR: Process %i exited abnormally! Code: %d\n", currentThread->getID(),arg1);
 				
-				if(currentThread->space)	// Delete the used memory from the process.
-					delete currentThread->space;
-				currentThread->Finish();	// Delete the thread.
+				EndProcess();	// Delete the used memory, and the thread.
 
 				break;
 			}
+			case SC_Fork :	// Start a new process in a copy of this one.
+			{
+				printf("SYSTEM CALL: Fork, called by thread %i.\n",currentThread->getID());
+
+				// Nothing is copied yet: the pages are shared, and
+				// copied by whichever process writes one first.
+				AddrSpace *space = new AddrSpace(currentThread->space, threadID);
+
+				// The child starts with our registers (and so our
+				// stack, as it is now), the PC already past the
+				// syscall: it goes on from our call to Fork, where
+				// it gets 0.
+				int *registers = new int[NumTotalRegs];
+				for (int r = 0; r < NumTotalRegs; r++)
+					registers[r] = machine->ReadRegister(r);
+				registers[2] = 0;
+
+				Thread* forkThread = new Thread("Wubba", currentThread->getFN());
+				forkThread->space = space;
+				forkThread->setID(threadID);
+				activeThreads->Append(forkThread);
+				machine->WriteRegister(2, threadID);	// Return the child's ID.
+				threadID++;
+				forkThread->Fork(forkedProcess, (int) registers);
+				break;
+			}
            case SC_Yield :	// Yield to a new process.
 		   {
 			   printf("SYSTEM CALL: Yield, called by thread %i.\n",currentThread->getID());
 
-			   //Save the registers and yield CPU control.
-			   currentThread->space->SaveState();
+			   //Yield CPU control.  The scheduler saves and
+			   //restores the address space around the switch.
 			   currentThread->Yield();
-			   //When the thread comes back, restore its registers.
-			   currentThread->space->RestoreState();
 
                break;
 			}
@@ -278,59 +331,63 @@ ExceptionHandler(ExceptionType which)
            break;
 
 	case ReadOnlyException :
+		// A page shared with a Forked process: write to a copy.
+		if (currentThread->space != NULL && currentThread->space->CopyOnWrite(
+				machine->ReadRegister(BadVAddrReg)))
+			break;		// and try the store again
 		printf("ERROR: ReadOnlyException, called by thread %i.\n",currentThread->getID());
 		if (currentThread->getName() == "main")
 			ASSERT(FALSE);  //Not the way of handling an exception.
-		if(currentThread->space)	// Delete the used memory from the process.
-			delete currentThread->space;
-		currentThread->Finish();	// Delete the thread.
+		EndProcess();		// Delete the process.
 		break;
 	case BusErrorException :
 		printf("ERROR: BusErrorException, called by thread %i.\n",currentThread->getID());
 		if (currentThread->getName() == "main")
 			ASSERT(FALSE);  //Not the way of handling an exception.
-		if(currentThread->space)	// Delete the used memory from the process.
-			delete currentThread->space;
-		currentThread->Finish();	// Delete the thread.
+		EndProcess();		// Delete the process.
 		break;
 	case AddressErrorException :
 		printf("ERROR: AddressErrorException, called by thread %i.\n",currentThread->getID());
 		if (currentThread->getName() == "main")
 			ASSERT(FALSE);  //Not the way of handling an exception.
-		if(currentThread->space)	// Delete the used memory from the process.
-			delete currentThread->space;
-		currentThread->Finish();	// Delete the thread.
+		EndProcess();		// Delete the process.
 		break;
 	case OverflowException :
 		printf("ERROR: OverflowException, called by thread %i.\n",currentThread->getID());
 		if (currentThread->getName() == "main")
 			ASSERT(FALSE);  //Not the way of handling an exception.
-		if(currentThread->space)	// Delete the used memory from the process.
-			delete currentThread->space;
-		currentThread->Finish();	// Delete the thread.
+		EndProcess();		// Delete the process.
 		break;
 	case IllegalInstrException :
 		printf("ERROR: IllegalInstrException, called by thread %i.\n",currentThread->getID());
 		if (currentThread->getName() == "main")
 			ASSERT(FALSE);  //Not the way of handling an exception.
-		if(currentThread->space)	// Delete the used memory from the process.
-			delete currentThread->space;
-		currentThread->Finish();	// Delete the thread.
+		EndProcess();		// Delete the process.
 		break;
 	case NumExceptionTypes :
 		printf("ERROR: NumExceptionTypes, called by thread %i.\n",currentThread->getID());
 		if (currentThread->getName() == "main")
 			ASSERT(FALSE);  //Not the way of handling an exception.
-		if(currentThread->space)	// Delete the used memory from the process.
-			delete currentThread->space;
-		currentThread->Finish();	// Delete the thread.
+		EndProcess();		// Delete the process.
 		break;
 
 	case PageFaultException: //begin code AF, code for the page fault exception
 	{
 		//printf("\npage fault hit\n");
+		if (machine->tlb != NULL) {	// usually just a TLB miss
+			ExceptionType miss = currentThread->space->HandleTLBMiss(
+					machine->ReadRegister(BadVAddrReg));
+			if (miss == NoException)
+				break;
+			if (miss != PageFaultException) {
+				ExceptionHandler(miss);
+				break;
+			}
+		}
 		faultcount++;
 		currentThread->space->HandlePageFault(machine->ReadRegister(BadVAddrReg));
+		if (machine->tlb != NULL)	// load it now, rather than miss again
+			currentThread->space->HandleTLBMiss(machine->ReadRegister(BadVAddrReg));
 
 		//int vpNum = machine->ReadRegister(BadVAddrReg) / PageSize; //getting index of the virtual 
 
@@ -396,9 +453,9 @@ static int SRead(int addr, int size, int id)  //input 0  output 1
 		}
 
 		for (num=0; num<Result; num++)
-		{  machine->WriteMem((addr+num), 1, (int) buffer[num]);
 			if (buffer[num] == '\0')
-			break; }
+				break;
+		CopyOut(addr, buffer, (num < Result) ? num + 1 : Result);
 		return num;
 
 	}
@@ -407,9 +464,9 @@ static int SRead(int addr, int size, int id)  //input 0  output 1
 	{
 		for(num=0;num<size;num++){
 			Read(id,&buffer[num],1);
-			machine->WriteMem((addr+num), 1, (int) buffer[num]);
 			if(buffer[num]=='\0') break;
 		}
+		CopyOut(addr, buffer, (num < size) ? num + 1 : size);
 		return num;
 	}
 }
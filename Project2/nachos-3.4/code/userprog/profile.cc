@@ -0,0 +1,285 @@
+// profile.cc
+//	Routines to count where user programs spend their instructions,
+//	and to print the results when the machine halts.
+//
+//	Counting is done by Machine::Run, which calls Profile::Count for
+//	each instruction when -P is given; the faster interpreters are
+//	not used while profiling.  Since every instruction takes one
+//	user tick, instruction counts are tick counts.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "profile.h"
+#include "mipssim.h"
+#include "noff.h"
+
+#define NumHotSpots	20	// how many of the busiest instructions,
+#define NumHotFunctions	10	// and functions, to list
+
+static Profile *firstProfile = NULL;	// all profiles made, in order
+static Profile *lastProfile = NULL;
+
+//----------------------------------------------------------------------
+// Profile::Profile
+// 	Set up an empty profile for a new address space.
+//
+//	"id" -- the process the address space belongs to
+//	"noffH" -- the header of the program it was loaded from
+//	"numPages" -- the size of the address space
+//----------------------------------------------------------------------
+
+Profile::Profile(int id, struct noffHeader *noffH, int pages)
+{
+    int i;
+
+    processId = id;
+    numPages = pages;
+    numWords = numPages * PageSize / 4;
+
+    // segments that are empty start where the one before them ends
+    dataStart = noffH->code.virtualAddr + noffH->code.size;
+    if (noffH->initData.size > 0)
+	dataStart = noffH->initData.virtualAddr;
+    bssStart = dataStart + noffH->initData.size;
+    if (noffH->uninitData.size > 0)
+	bssStart = noffH->uninitData.virtualAddr;
+    stackStart = bssStart + noffH->uninitData.size;
+
+    total = 0;
+    pcCount = new int[numWords];
+    pcOp = new unsigned char[numWords];
+    isEntry = new bool[numWords];
+    for (i = 0; i < numWords; i++) {
+	pcCount[i] = 0;
+	pcOp[i] = 0;
+	isEntry[i] = FALSE;
+    }
+    if (noffH->code.size > 0 && noffH->code.virtualAddr / 4 < numWords)
+	isEntry[noffH->code.virtualAddr / 4] = TRUE;
+    opCount = new int[MaxOpcode + 1];
+    for (i = 0; i <= MaxOpcode; i++)
+	opCount[i] = 0;
+    loads = new int[numPages];
+    stores = new int[numPages];
+    for (i = 0; i < numPages; i++)
+	loads[i] = stores[i] = 0;
+
+    next = NULL;
+    if (lastProfile == NULL)
+	firstProfile = this;
+    else
+	lastProfile->next = this;
+    lastProfile = this;
+}
+
+//----------------------------------------------------------------------
+// Profile::~Profile
+// 	De-allocate a profile.  (Profiles are normally kept until the
+//	machine halts.)
+//----------------------------------------------------------------------
+
+Profile::~Profile()
+{
+    delete [] pcCount;
+    delete [] pcOp;
+    delete [] isEntry;
+    delete [] opCount;
+    delete [] loads;
+    delete [] stores;
+}
+
+//----------------------------------------------------------------------
+// Profile::Count
+// 	Count one instruction.  This is the only per-instruction cost
+//	of profiling; Machine::Run doesn't call it unless -P was given.
+//
+//	"instr" -- the instruction about to be executed
+//	"registers" -- the machine's registers, as they are before it runs
+//----------------------------------------------------------------------
+
+void
+Profile::Count(Instruction *instr, int *registers)
+{
+    unsigned int pc = registers[PCReg];
+    unsigned int page, target;
+
+    if (pc / 4 < (unsigned) numWords) {
+	pcCount[pc / 4]++;
+	pcOp[pc / 4] = instr->opCode;
+    }
+    opCount[instr->opCode]++;
+    total++;
+
+    switch (instr->opCode) {
+      case OP_LB: case OP_LBU: case OP_LH: case OP_LHU:
+      case OP_LW: case OP_LWL: case OP_LWR:
+	page = (unsigned) (registers[instr->rs] + instr->extra) / PageSize;
+	if (page < (unsigned) numPages)
+	    loads[page]++;
+	break;
+
+      case OP_SB: case OP_SH: case OP_SW: case OP_SWL: case OP_SWR:
+	page = (unsigned) (registers[instr->rs] + instr->extra) / PageSize;
+	if (page < (unsigned) numPages)
+	    stores[page]++;
+	break;
+
+      case OP_JAL:
+	target = instr->extra;
+	if (target < (unsigned) numWords)
+	    isEntry[target] = TRUE;
+	break;
+
+      case OP_JALR:
+	target = (unsigned) registers[instr->rs] / 4;
+	if (target < (unsigned) numWords)
+	    isEntry[target] = TRUE;
+	break;
+    }
+}
+
+//----------------------------------------------------------------------
+// Profile::SegmentOf
+// 	Return the name of the segment an address is in.
+//----------------------------------------------------------------------
+
+char *
+Profile::SegmentOf(int addr)
+{
+    if (addr < dataStart)
+	return "code";
+    else if (addr < bssStart)
+	return "data";
+    else if (addr < stackStart)
+	return "bss";
+    return "stack";
+}
+
+//----------------------------------------------------------------------
+// Profile::FunctionOf
+// 	Return the address of the function the code at "addr" belongs
+//	to: the nearest known entry point at or below it.
+//----------------------------------------------------------------------
+
+int
+Profile::FunctionOf(int addr)
+{
+    for (int i = addr / 4; i >= 0; i--)
+	if (isEntry[i])
+	    return i * 4;
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// PrintOp
+// 	Print the mnemonic of an opcode, padded to a fixed width.
+//----------------------------------------------------------------------
+
+static void
+PrintOp(int opCode)
+{
+    char *string = opStrings[opCode].string;
+
+    printf("%-8.*s", (int) strcspn(string, " "), string);
+}
+
+//----------------------------------------------------------------------
+// Busiest
+// 	Return the index of the largest count in "counts" that is not
+//	yet marked in "done" (and mark it), or -1 if all that remain are
+//	zero.  Used to list the top few entries without sorting.
+//----------------------------------------------------------------------
+
+static int
+Busiest(int *counts, bool *done, int n)
+{
+    int best = -1;
+
+    for (int i = 0; i < n; i++)
+	if (!done[i] && counts[i] > 0 && (best < 0 || counts[i] > counts[best]))
+	    best = i;
+    if (best >= 0)
+	done[best] = TRUE;
+    return best;
+}
+
+//----------------------------------------------------------------------
+// Profile::Print
+// 	Print the instruction mix, the busiest functions and
+//	instructions, and the loads and stores to each page.
+//----------------------------------------------------------------------
+
+void
+Profile::Print()
+{
+    int *funcCount, i, n, entry;
+    bool *done;
+
+    if (total == 0)
+	return;
+    funcCount = new int[numWords];
+    done = new bool[max(numWords, MaxOpcode + 1)];
+    printf("Profile of process %d: %d instructions\n", processId, total);
+
+    printf("  By opcode:\n");
+    for (i = 0; i <= MaxOpcode; i++)
+	done[i] = FALSE;
+    while ((i = Busiest(opCount, done, MaxOpcode + 1)) >= 0) {
+	printf("\t");
+	PrintOp(i);
+	printf("%10d  %5.1f%%\n", opCount[i], 100.0 * opCount[i] / total);
+    }
+
+    // charge each instruction to the function it's in
+    for (i = 0; i < numWords; i++)
+	funcCount[i] = 0;
+    for (i = 0, entry = 0; i < numWords; i++) {
+	if (isEntry[i])
+	    entry = i;
+	funcCount[entry] += pcCount[i];
+    }
+    printf("  Hot functions:\n");
+    for (i = 0; i < numWords; i++)
+	done[i] = FALSE;
+    for (n = 0; n < NumHotFunctions
+		&& (i = Busiest(funcCount, done, numWords)) >= 0; n++)
+	printf("\t%s 0x%-6x%10d  %5.1f%%\n", SegmentOf(i * 4), i * 4,
+		funcCount[i], 100.0 * funcCount[i] / total);
+
+    printf("  Hot spots:\n");
+    for (i = 0; i < numWords; i++)
+	done[i] = FALSE;
+    for (n = 0; n < NumHotSpots
+		&& (i = Busiest(pcCount, done, numWords)) >= 0; n++) {
+	entry = FunctionOf(i * 4);
+	printf("\t0x%-6x 0x%x+0x%-4x ", i * 4, entry, i * 4 - entry);
+	PrintOp(pcOp[i]);
+	printf("%10d  %5.1f%%\n", pcCount[i], 100.0 * pcCount[i] / total);
+    }
+
+    printf("  Loads and stores by page:\n");
+    for (i = 0; i < numPages; i++)
+	if (loads[i] + stores[i] > 0)
+	    printf("\tpage %3d %-5s  loads %9d  stores %9d\n", i,
+		    SegmentOf(i * PageSize), loads[i], stores[i]);
+
+    delete [] funcCount;
+    delete [] done;
+}
+
+//----------------------------------------------------------------------
+// PrintProfiles
+// 	Print every profile made since the machine started, skipping any
+//	address space that never ran.
+//----------------------------------------------------------------------
+
+void
+PrintProfiles()
+{
+    for (Profile *p = firstProfile; p != NULL; p = p->next)
+	p->Print();
+}
@@ -0,0 +1,61 @@
+// profile.h
+//	Data structures for profiling user programs (-P).
+//
+//	While profiling, Machine::Run counts every user instruction it
+//	fetches: by PC, by opcode, and for loads and stores, by the
+//	virtual page they touch.  Each address space gets its own
+//	Profile, which outlives it, so that all of them can be printed
+//	when the machine halts.
+//
+//	NOFF files carry no symbols, so hot spots are named by segment
+//	(code, data, bss, stack), and code addresses by the nearest
+//	function entry below them -- any address the program was seen to
+//	call with JAL or JALR, or the start of the code segment.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+#include "machine.h"
+
+struct noffHeader;			// see noff.h
+
+class Profile {
+  public:
+    Profile(int id, struct noffHeader *noffH, int numPages);
+					// Set up an empty profile for process
+					// "id", laid out as "noffH" says
+    ~Profile();
+
+    void Count(Instruction *instr, int *registers);
+					// Count the instruction about to run
+					// at registers[PCReg]
+    void Print();			// Print the results
+
+    Profile *next;			// next one made, for PrintProfiles
+
+  private:
+    char *SegmentOf(int addr);		// "code", "data", "bss" or "stack"
+    int FunctionOf(int addr);		// entry point of code at "addr"
+
+    int processId;
+    int dataStart, bssStart, stackStart; // where the segments are
+    int numPages;			// size of the address space
+    int numWords;			// ... in instruction words
+
+    int total;				// instructions counted
+    int *pcCount;			// per instruction word
+    unsigned char *pcOp;		// ... and the opcode found there
+    bool *isEntry;			// per word: is it a call target?
+    int *opCount;			// per opcode
+    int *loads, *stores;		// per virtual page
+};
+
+extern void PrintProfiles();		// Print every profile made so far;
+					// called when the machine halts
+
+#endif // PROFILE_H
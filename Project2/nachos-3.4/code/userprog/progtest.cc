@@ -43,10 +43,10 @@ StartProcess(char *filename)
         printf("Demand Paging.\n");
     else if(repChoice == -1)
         printf("Demand Paging by default.\n");
-    else if(repChoice == 1)
-        printf("First in, First out.\n");
+    else if(replacer != NULL)
+        printf("%s.\n", replacer->Name());
     else
-        printf("Random Replacement.\n");
+        printf("Demand Paging (no such policy).\n");
     //End changes by Alec Hebert
 	printf("Memory allocation method chosen: ");
 	if(memChoice == 1)
@@ -56,11 +56,11 @@ StartProcess(char *filename)
 	else
 		printf("Worst-fit.\n\n");
 	
-    space = new AddrSpace(executable, currentThread->getID());    
+    space = new AddrSpace(executable, currentThread->getID(), filename);    
     currentThread->space = space;
     currentThread->setFN(filename);
 
-    delete executable;			// close file
+    // the space keeps the executable open, to page from it
 
     space->InitRegisters();		// set the initial register values
     space->RestoreState();		// load page table register
@@ -0,0 +1,101 @@
+// reclaim.cc
+//	Routines for the free-frame pool's reclaim thread (-FP).  See
+//	reclaim.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "addrspace.h"
+#include "reclaim.h"
+
+//----------------------------------------------------------------------
+// ReclaimThread
+// 	The reclaimer's thread: wait to be woken, refill the pool of free
+//	frames, and go back to sleep.
+//----------------------------------------------------------------------
+
+static void
+ReclaimThread(int arg)
+{
+    FrameReclaimer *self = (FrameReclaimer *) arg;
+
+    for (;;)
+	self->Reclaim();
+}
+
+//----------------------------------------------------------------------
+// FrameReclaimer::FrameReclaimer
+// 	Fork the reclaim thread; it goes to sleep straight away, since
+//	all of memory is free.  The watermarks are kept sensible: at
+//	least one frame is left for pages to be in.
+//----------------------------------------------------------------------
+
+FrameReclaimer::FrameReclaimer(int low, int high)
+{
+    highWater = max(1, min(high, NumPhysPages - 1));
+    lowWater = max(1, min(low, highWater));
+    thread = new Thread("frame reclaimer");
+    asleep = woken = FALSE;
+    thread->Fork(ReclaimThread, (int) this);
+}
+
+FrameReclaimer::~FrameReclaimer()
+{
+}
+
+//----------------------------------------------------------------------
+// FrameReclaimer::Fault
+// 	A page fault has just taken a frame.  If fewer than the low 
+//	watermark are left, let the reclaimer run, next time there is a
+//	context switch.
+//----------------------------------------------------------------------
+
+void
+FrameReclaimer::Fault()
+{
+    IntStatus oldLevel;
+
+    if (memMap->NumClear() >= lowWater)
+	return;
+    oldLevel = interrupt->SetLevel(IntOff);
+    if (!woken) {
+	woken = TRUE;
+	if (asleep) {
+	    asleep = FALSE;
+	    scheduler->ReadyToRunFirst(thread);
+	}
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// FrameReclaimer::Reclaim
+// 	Wait until woken, then evict the pages the replacement policy
+//	picks until the high watermark of frames is free.  No page is
+//	faulting, so the policy isn't told of one.
+//----------------------------------------------------------------------
+
+void
+FrameReclaimer::Reclaim()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    while (!woken) {
+	asleep = TRUE;
+	currentThread->Sleep();
+    }
+    woken = FALSE;
+    (void) interrupt->SetLevel(oldLevel);
+    stats->numReclaimRuns++;
+
+    while (memMap->NumClear() < highWater) {
+	int pPage = replacer->ChooseVictim(NULL, -1, NULL);
+
+	frameTable[pPage].space->SwapOut(pPage);
+	memMap->Clear(pPage);
+	stats->numFramesReclaimed++;
+    }
+}
@@ -0,0 +1,52 @@
+// reclaim.h
+//	Data structures for the free-frame pool (-FP): a kernel thread
+//	that evicts pages ahead of time, so that a page fault usually
+//	finds a free frame and doesn't have to wait for a page to be
+//	chosen and written out first.
+//
+//	The reclaimer sleeps until a page fault leaves fewer than the low
+//	watermark of frames free.  It then asks the replacement policy 
+//	for victims, and evicts them, until the high watermark of frames
+//	is free; the free frames are simply the clear bits of memMap.
+//	If the pool runs dry before it gets to run, the fault evicts a
+//	page itself, as it would without the pool.
+//
+//	Like the page cleaner, once woken the reclaimer goes to the front
+//	of the ready list, and the timer makes the running thread stand
+//	aside for it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RECLAIM_H
+#define RECLAIM_H
+
+#include "copyright.h"
+#include "thread.h"
+
+class FrameReclaimer {
+  public:
+    FrameReclaimer(int low, int high);	// Start the reclaim thread, to
+					// keep between "low" and "high"
+					// frames free
+    ~FrameReclaimer();
+
+    void Fault();			// Called when a page fault has taken
+					// a frame; wakes the reclaimer if
+					// that leaves too few free
+    bool Pending() { return woken; }	// Is it waiting to run?
+
+    void Reclaim();			// Free frames up to the high 
+					// watermark; the body of the 
+					// thread's loop
+
+  private:
+    Thread *thread;			// the reclaim thread
+    bool asleep;			// is it waiting to be woken?
+    bool woken;				// woken, but hasn't run yet
+    int lowWater;			// wake below this many free frames
+    int highWater;			// ... and free this many
+};
+
+#endif // RECLAIM_H
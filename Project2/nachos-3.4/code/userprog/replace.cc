@@ -0,0 +1,687 @@
+// replace.cc
+//	The page replacement policies that can be chosen with -V:
+//
+//	  1  FIFO: the frame that was filled longest ago
+//	  2  Random
+//	  3  Clock (second chance): a hand sweeps the frames, clearing
+//	     use bits, and stops at one not used since it last came round
+//	  4  Enhanced NRU: like the clock, but an unused clean page is
+//	     taken before an unused dirty one, to save a swap write
+//	  5  Aging, an approximation of LRU: every timer interrupt, each
+//	     frame's counter is shifted right with its use bit shifted in
+//	     at the top; the frame with the smallest counter is taken
+//	  6  ARC (adaptive replacement cache; Megiddo and Modha): pages
+//	     seen once and pages seen again are kept on separate LRU
+//	     lists, with the split between them adjusted by faults on
+//	     pages recently evicted from either list
+//
+//	None of them can see individual memory references, only the use
+//	bits the hardware sets, so "LRU" order is the order in which use
+//	bits were found set.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "addrspace.h"
+#include "replace.h"
+
+//----------------------------------------------------------------------
+// FramePTE
+// 	Return the page table entry for whatever is in physical page
+//	"pPage", with any use and dirty bits its TLB entry has gathered
+//	copied into it first.
+//----------------------------------------------------------------------
+
+static TranslationEntry *
+FramePTE(int pPage)
+{
+    AddrSpace *owner = frameTable[pPage].space;
+
+    owner->SyncTLBEntry(frameTable[pPage].virtualPage);
+    return owner->getEntry(frameTable[pPage].virtualPage);
+}
+
+//----------------------------------------------------------------------
+// ClearUse
+// 	Clear the use bit of the page in "pPage", whose page table entry
+//	is "entry", first telling fault-around (-FA) if this shows that a
+//	page it brought in has been used.
+//----------------------------------------------------------------------
+
+static void
+ClearUse(int pPage, TranslationEntry *entry)
+{
+    if (entry->use && frameTable[pPage].prefetched)
+	frameTable[pPage].space->PrefetchUsed(pPage);
+    entry->use = FALSE;
+}
+
+//----------------------------------------------------------------------
+// Replaceable
+// 	Is there a user page in "pPage" that may be evicted?  If "owner"
+//	isn't NULL, it must be one of owner's.
+//----------------------------------------------------------------------
+
+static bool
+Replaceable(int pPage, AddrSpace *owner)
+{
+    return frameTable[pPage].space != NULL && frameTable[pPage].pinCount == 0
+	&& (owner == NULL || frameTable[pPage].space == owner);
+}
+
+//----------------------------------------------------------------------
+// ReplacementPolicy::RecentlyUsed
+// 	Has the page in "pPage" been used lately, so that it is unlikely
+//	to be replaced soon?  Policies that clear use bits often may want
+//	to look further back.
+//----------------------------------------------------------------------
+
+bool
+ReplacementPolicy::RecentlyUsed(int pPage)
+{
+    return FramePTE(pPage)->use;
+}
+
+//----------------------------------------------------------------------
+// FrameList::FrameList, Append, Remove
+// 	A doubly linked list of physical pages.  See replace.h.
+//----------------------------------------------------------------------
+
+FrameList::FrameList(int *prevFrame, int *nextFrame)
+{
+    prev = prevFrame;
+    next = nextFrame;
+    first = last = -1;
+    size = 0;
+}
+
+void
+FrameList::Append(int pPage)
+{
+    prev[pPage] = last;
+    next[pPage] = -1;
+    if (last == -1)
+	first = pPage;
+    else
+	next[last] = pPage;
+    last = pPage;
+    size++;
+}
+
+void
+FrameList::Remove(int pPage)
+{
+    if (prev[pPage] == -1)
+	first = next[pPage];
+    else
+	next[prev[pPage]] = next[pPage];
+    if (next[pPage] == -1)
+	last = prev[pPage];
+    else
+	prev[next[pPage]] = prev[pPage];
+    size--;
+}
+
+// Whether a frame is on a policy's list is kept in policyInfo, so
+// that PageFree can tell if it still has to be taken off.
+
+#define OnList	1
+
+//----------------------------------------------------------------------
+// FIFOPolicy (-V 1)
+// 	Frames are queued as they are filled, and taken off when emptied.
+//----------------------------------------------------------------------
+
+class FIFOPolicy : public ReplacementPolicy {
+  public:
+    FIFOPolicy();
+    ~FIFOPolicy();
+    char *Name() { return "First in, First out"; }
+    void PageIn(int pPage);
+    void PageFree(int pPage);
+    int ChooseVictim(AddrSpace *space, int vPage, AddrSpace *owner);
+
+  private:
+    int *prev, *next;
+    FrameList *queue;
+};
+
+FIFOPolicy::FIFOPolicy()
+{
+    prev = new int[NumPhysPages];
+    next = new int[NumPhysPages];
+    queue = new FrameList(prev, next);
+}
+
+FIFOPolicy::~FIFOPolicy()
+{
+    delete queue;
+    delete [] prev;
+    delete [] next;
+}
+
+void
+FIFOPolicy::PageIn(int pPage)
+{
+    queue->Append(pPage);
+    frameTable[pPage].policyInfo = OnList;
+}
+
+void
+FIFOPolicy::PageFree(int pPage)
+{
+    if (frameTable[pPage].policyInfo == OnList) {
+	queue->Remove(pPage);
+	frameTable[pPage].policyInfo = 0;
+    }
+}
+
+int
+FIFOPolicy::ChooseVictim(AddrSpace *space, int vPage, AddrSpace *owner)
+{
+    for (int pPage = queue->First(); pPage != -1; pPage = queue->Next(pPage))
+	if (Replaceable(pPage, owner))
+	    return pPage;		// pinned frames keep their place
+    ASSERT(FALSE);
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// RandomPolicy (-V 2)
+//----------------------------------------------------------------------
+
+class RandomPolicy : public ReplacementPolicy {
+  public:
+    char *Name() { return "Random Replacement"; }
+    int ChooseVictim(AddrSpace *space, int vPage, AddrSpace *owner);
+};
+
+int
+RandomPolicy::ChooseVictim(AddrSpace *space, int vPage, AddrSpace *owner)
+{
+    int pPage;
+
+    do
+	pPage = Random() % NumPhysPages;
+    while (!Replaceable(pPage, owner));
+    return pPage;
+}
+
+//----------------------------------------------------------------------
+// ClockPolicy (-V 3)
+// 	The hand sweeps the frames in order, clearing use bits; the
+//	first frame it finds that hasn't been used since the hand last
+//	passed is the victim.
+//----------------------------------------------------------------------
+
+class ClockPolicy : public ReplacementPolicy {
+  public:
+    ClockPolicy() { hand = 0; }
+    char *Name() { return "Clock"; }
+    int ChooseVictim(AddrSpace *space, int vPage, AddrSpace *owner);
+
+  private:
+    int hand;				// next frame to look at
+};
+
+int
+ClockPolicy::ChooseVictim(AddrSpace *space, int vPage, AddrSpace *owner)
+{
+    for (int n = 0; n < 2 * NumPhysPages; n++) {
+	int pPage = hand;
+	TranslationEntry *entry;
+
+	hand = (hand + 1) % NumPhysPages;
+	if (!Replaceable(pPage, owner))
+	    continue;
+	entry = FramePTE(pPage);
+	if (!entry->use)
+	    return pPage;
+	ClearUse(pPage, entry);
+    }
+    ASSERT(FALSE);			// every frame is pinned
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// NRUPolicy (-V 4)
+// 	Frames are classed by their use and dirty bits, and one is taken
+//	from the lowest class there is.  Like the clock, the hand first
+//	looks for an unused clean page without changing anything, then
+//	for an unused dirty one, clearing use bits as it goes; if neither
+//	turns up, every use bit is now clear and the two passes are tried
+//	once more.
+//----------------------------------------------------------------------
+
+class NRUPolicy : public ReplacementPolicy {
+  public:
+    NRUPolicy() { hand = 0; }
+    char *Name() { return "Enhanced NRU"; }
+    int ChooseVictim(AddrSpace *space, int vPage, AddrSpace *owner);
+
+  private:
+    int hand;				// next frame to look at
+};
+
+int
+NRUPolicy::ChooseVictim(AddrSpace *space, int vPage, AddrSpace *owner)
+{
+    for (int round = 0; round < 2; round++) {
+	for (int dirtyOk = 0; dirtyOk < 2; dirtyOk++) {
+	    for (int n = 0; n < NumPhysPages; n++) {
+		int pPage = hand;
+		TranslationEntry *entry;
+
+		hand = (hand + 1) % NumPhysPages;
+		if (!Replaceable(pPage, owner))
+		    continue;
+		entry = FramePTE(pPage);
+		if (!entry->use && (dirtyOk || !entry->dirty))
+		    return pPage;
+		if (dirtyOk)
+		    ClearUse(pPage, entry);
+	    }
+	}
+    }
+    ASSERT(FALSE);			// every frame is pinned
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// AgingPolicy (-V 5)
+// 	Each frame's policyInfo is an age counter: its use bits from the
+//	last 32 samples, the most recent in the top bit.  The frame with
+//	the smallest counter has gone longest without being used.
+//----------------------------------------------------------------------
+
+class AgingPolicy : public ReplacementPolicy {
+  public:
+    char *Name() { return "Aging (approximate LRU)"; }
+    void PageIn(int pPage) { frameTable[pPage].policyInfo = 0; }
+    int ChooseVictim(AddrSpace *space, int vPage, AddrSpace *owner);
+    bool NeedsSampling() { return TRUE; }
+    void Sample();
+    bool RecentlyUsed(int pPage)	// in any of the last 32 samples
+	{ return frameTable[pPage].policyInfo != 0 || FramePTE(pPage)->use; }
+};
+
+void
+AgingPolicy::Sample()
+{
+    for (int pPage = 0; pPage < NumPhysPages; pPage++) {
+	TranslationEntry *entry;
+	unsigned int age;
+
+	if (frameTable[pPage].space == NULL)
+	    continue;
+	entry = FramePTE(pPage);
+	age = (unsigned int) frameTable[pPage].policyInfo >> 1;
+	if (entry->use)
+	    age |= 0x80000000;
+	frameTable[pPage].policyInfo = (int) age;
+	ClearUse(pPage, entry);
+    }
+}
+
+int
+AgingPolicy::ChooseVictim(AddrSpace *space, int vPage, AddrSpace *owner)
+{
+    unsigned int age, youngest = 0;
+    int victim = -1;
+
+    for (int pPage = 0; pPage < NumPhysPages; pPage++) {
+	if (!Replaceable(pPage, owner))
+	    continue;
+
+	// what the next sample would make it: a page used since the
+	// last one is younger than any that wasn't
+	age = (unsigned int) frameTable[pPage].policyInfo >> 1;
+	if (FramePTE(pPage)->use)
+	    age |= 0x80000000;
+	if (victim == -1 || age < youngest) {
+	    victim = pPage;
+	    youngest = age;
+	}
+    }
+    ASSERT(victim != -1);		// every frame is pinned
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// GhostList
+// 	ARC's record of pages recently evicted, oldest first.  Pages are
+//	named by process id and virtual page, rather than by AddrSpace,
+//	since the space may be gone (and its memory reused) by the time
+//	one of them is looked up.
+//
+//	Entries live in a fixed set of slots, chained both in age order
+//	and by hash of their name, so a lookup costs one bucket and
+//	adding or forgetting a page never moves the others.
+//----------------------------------------------------------------------
+
+class GhostList {
+  public:
+    GhostList(int maxSize);		// it forgets the oldest page when
+					// it would grow beyond "maxSize"
+    ~GhostList();
+
+    int Find(int id, int vPage);	// slot holding a page, or -1
+    void Append(int id, int vPage);	// add a page as the newest
+    void Remove(int slot);		// forget the page in "slot"
+    void RemoveOldest() { Remove(oldest); }
+    int Size() { return size; }
+
+  private:
+    int Hash(int id, int vPage)
+	{ return (unsigned int) (id * 31 + vPage) % limit; }
+
+    int *ids, *pages;
+    int *older, *newer;			// age order, -1 at either end
+    int *chain;				// next slot in the same bucket,
+					// or on the list of spare slots
+    int *buckets;			// first slot of each bucket, or -1
+    int oldest, newest, spare;
+    int size, limit;
+};
+
+GhostList::GhostList(int maxSize)
+{
+    ASSERT(maxSize > 0);
+    ids = new int[maxSize];
+    pages = new int[maxSize];
+    older = new int[maxSize];
+    newer = new int[maxSize];
+    chain = new int[maxSize];
+    buckets = new int[maxSize];
+    for (int i = 0; i < maxSize; i++) {
+	chain[i] = i + 1;
+	buckets[i] = -1;
+    }
+    chain[maxSize - 1] = -1;
+    spare = 0;
+    oldest = newest = -1;
+    size = 0;
+    limit = maxSize;
+}
+
+GhostList::~GhostList()
+{
+    delete [] ids;
+    delete [] pages;
+    delete [] older;
+    delete [] newer;
+    delete [] chain;
+    delete [] buckets;
+}
+
+int
+GhostList::Find(int id, int vPage)
+{
+    for (int i = buckets[Hash(id, vPage)]; i != -1; i = chain[i])
+	if (ids[i] == id && pages[i] == vPage)
+	    return i;
+    return -1;
+}
+
+void
+GhostList::Append(int id, int vPage)
+{
+    int i, bucket = Hash(id, vPage);
+
+    if (size == limit)
+	RemoveOldest();
+    i = spare;
+    spare = chain[i];
+    ids[i] = id;
+    pages[i] = vPage;
+    chain[i] = buckets[bucket];
+    buckets[bucket] = i;
+    older[i] = newest;
+    newer[i] = -1;
+    if (newest != -1)
+	newer[newest] = i;
+    else
+	oldest = i;
+    newest = i;
+    size++;
+}
+
+void
+GhostList::Remove(int slot)
+{
+    int *link = &buckets[Hash(ids[slot], pages[slot])];
+
+    while (*link != slot)
+	link = &chain[*link];
+    *link = chain[slot];
+    if (older[slot] != -1)
+	newer[older[slot]] = newer[slot];
+    else
+	oldest = newer[slot];
+    if (newer[slot] != -1)
+	older[newer[slot]] = older[slot];
+    else
+	newest = older[slot];
+    chain[slot] = spare;
+    spare = slot;
+    size--;
+}
+
+//----------------------------------------------------------------------
+// ARCPolicy (-V 6)
+// 	Resident pages are on T1 (used once since they came in) or T2
+//	(used again), each kept in LRU order; B1 and B2 remember the
+//	pages recently evicted from them.  "target" is how many frames
+//	T1 should have.  A fault on a page in B1 means T1 was too small,
+//	one in B2 that T2 was, and target moves accordingly.
+//
+//	Reuse is seen by sampling use bits each timer interrupt; faults
+//	go by the lists as of the last sample.  The first sample after a
+//	page comes in ignores its use bit, which is only the faulting
+//	reference itself.
+//----------------------------------------------------------------------
+
+#define InT1	1		// policyInfo: which list the frame is on,
+#define InT2	2
+#define Fresh	4		// and whether it has been sampled yet
+
+class ARCPolicy : public ReplacementPolicy {
+  public:
+    ARCPolicy();
+    ~ARCPolicy();
+    char *Name() { return "ARC"; }
+    void PageIn(int pPage);
+    void PageFree(int pPage);
+    int ChooseVictim(AddrSpace *space, int vPage, AddrSpace *owner);
+    bool NeedsSampling() { return TRUE; }
+    void Sample();
+    bool RecentlyUsed(int pPage);
+
+  private:
+    void Adapt(int id, int vPage);	// move target on a ghost hit
+    int Oldest(FrameList *list, AddrSpace *owner);
+					// first replaceable frame, or -1
+
+    int *prev, *next;
+    FrameList *t1, *t2;
+    GhostList *b1, *b2;
+    int target;
+    int adaptedId, adaptedPage;		// page ChooseVictim already
+					// adapted for, so PageIn won't
+};
+
+ARCPolicy::ARCPolicy()
+{
+    prev = new int[NumPhysPages];
+    next = new int[NumPhysPages];
+    t1 = new FrameList(prev, next);
+    t2 = new FrameList(prev, next);
+    b1 = new GhostList(NumPhysPages);
+    b2 = new GhostList(NumPhysPages);
+    target = 0;
+    adaptedId = adaptedPage = -1;
+}
+
+ARCPolicy::~ARCPolicy()
+{
+    delete t1;
+    delete t2;
+    delete b1;
+    delete b2;
+    delete [] prev;
+    delete [] next;
+}
+
+void
+ARCPolicy::Adapt(int id, int vPage)
+{
+    if (id == adaptedId && vPage == adaptedPage)
+	return;
+    if (b1->Find(id, vPage) != -1)
+	target = min(NumPhysPages,
+		target + max(b2->Size() / max(b1->Size(), 1), 1));
+    else if (b2->Find(id, vPage) != -1)
+	target = max(0, target - max(b1->Size() / max(b2->Size(), 1), 1));
+    adaptedId = id;
+    adaptedPage = vPage;
+}
+
+void
+ARCPolicy::PageIn(int pPage)
+{
+    int id = frameTable[pPage].space->getID();
+    int vPage = frameTable[pPage].virtualPage;
+    int i;
+
+    Adapt(id, vPage);
+    adaptedId = adaptedPage = -1;
+
+    if ((i = b1->Find(id, vPage)) != -1) {
+	b1->Remove(i);
+	t2->Append(pPage);
+	frameTable[pPage].policyInfo = InT2 | Fresh;
+    } else if ((i = b2->Find(id, vPage)) != -1) {
+	b2->Remove(i);
+	t2->Append(pPage);
+	frameTable[pPage].policyInfo = InT2 | Fresh;
+    } else {
+	// keep the history to one memory's worth of pages per side
+	if (t1->Size() + b1->Size() >= NumPhysPages && b1->Size() > 0)
+	    b1->RemoveOldest();
+	else if (t1->Size() + t2->Size() + b1->Size() + b2->Size()
+			>= 2 * NumPhysPages && b2->Size() > 0)
+	    b2->RemoveOldest();
+	t1->Append(pPage);
+	frameTable[pPage].policyInfo = InT1 | Fresh;
+    }
+}
+
+void
+ARCPolicy::PageFree(int pPage)
+{
+    if (frameTable[pPage].policyInfo & InT1)
+	t1->Remove(pPage);
+    else if (frameTable[pPage].policyInfo & InT2)
+	t2->Remove(pPage);
+    frameTable[pPage].policyInfo = 0;
+}
+
+void
+ARCPolicy::Sample()
+{
+    for (int pPage = 0; pPage < NumPhysPages; pPage++) {
+	TranslationEntry *entry;
+
+	if (frameTable[pPage].space == NULL || frameTable[pPage].policyInfo == 0)
+	    continue;
+	entry = FramePTE(pPage);
+	if (frameTable[pPage].policyInfo & Fresh)
+	    frameTable[pPage].policyInfo &= ~Fresh;
+	else if (entry->use) {		// used again: most recent on T2
+	    PageFree(pPage);
+	    t2->Append(pPage);
+	    frameTable[pPage].policyInfo = InT2;
+	}
+	ClearUse(pPage, entry);
+    }
+}
+
+// Use bits are cleared on every sample, so go by where the frame is
+// on its list instead: only the older half is near to being replaced.
+bool
+ARCPolicy::RecentlyUsed(int pPage)
+{
+    FrameList *list;
+    int older;
+
+    if (FramePTE(pPage)->use || frameTable[pPage].policyInfo == 0)
+	return TRUE;
+    list = (frameTable[pPage].policyInfo & InT1) ? t1 : t2;
+    older = (list->Size() + 1) / 2;
+    for (int p = list->First(); older > 0; p = list->Next(p), older--)
+	if (p == pPage)
+	    return FALSE;
+    return TRUE;
+}
+
+int
+ARCPolicy::Oldest(FrameList *list, AddrSpace *owner)
+{
+    for (int pPage = list->First(); pPage != -1; pPage = list->Next(pPage))
+	if (Replaceable(pPage, owner))
+	    return pPage;
+    return -1;
+}
+
+int
+ARCPolicy::ChooseVictim(AddrSpace *space, int vPage, AddrSpace *owner)
+{
+    bool inB2 = space != NULL && b2->Find(space->getID(), vPage) != -1;
+    int pPage;
+
+    // the lists are as of the last timer sample, which is recent
+    // enough; resampling here would cost a pass over every frame
+    if (space != NULL)
+	Adapt(space->getID(), vPage);
+
+    // evict from T1 if it's bigger than it should be, else from T2
+    if (t1->Size() > 0 && (t1->Size() > target
+			   || (inB2 && t1->Size() == target))) {
+	if ((pPage = Oldest(t1, owner)) == -1)
+	    pPage = Oldest(t2, owner);
+    } else if ((pPage = Oldest(t2, owner)) == -1)
+	pPage = Oldest(t1, owner);
+    ASSERT(pPage != -1);		// every frame is pinned
+
+    if (frameTable[pPage].policyInfo & InT1)
+	b1->Append(frameTable[pPage].space->getID(),
+		   frameTable[pPage].virtualPage);
+    else
+	b2->Append(frameTable[pPage].space->getID(),
+		   frameTable[pPage].virtualPage);
+    PageFree(pPage);
+    return pPage;
+}
+
+//----------------------------------------------------------------------
+// NewReplacementPolicy
+// 	Make the policy -V "choice" asks for, or return NULL if it means
+//	demand paging without replacement.
+//----------------------------------------------------------------------
+
+ReplacementPolicy *
+NewReplacementPolicy(int choice)
+{
+    switch (choice) {
+      case 1: return new FIFOPolicy;
+      case 2: return new RandomPolicy;
+      case 3: return new ClockPolicy;
+      case 4: return new NRUPolicy;
+      case 5: return new AgingPolicy;
+      case 6: return new ARCPolicy;
+    }
+    return NULL;
+}
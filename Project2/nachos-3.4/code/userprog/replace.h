@@ -0,0 +1,81 @@
+// replace.h
+//	Data structures for choosing which page to evict when physical
+//	memory is full.
+//
+//	A ReplacementPolicy is told when a frame is filled (PageIn) and
+//	when it is emptied (PageFree), may look at the use bits of the
+//	pages in memory from time to time (Sample, on timer interrupts),
+//	and picks the frame to take back when a page fault finds no free
+//	frame (ChooseVictim).  The one in use is chosen with -V when
+//	Nachos starts; see NewReplacementPolicy.
+//
+//	Policies keep whatever they need per frame in the frame table
+//	(FrameEntry::policyInfo), and must not pick a pinned frame.
+//	With per-process frame quotas (-PFF), the fault handler may also
+//	say whose frame to take.  With a free-frame pool (-FP), victims
+//	are also chosen ahead of time, when no page is faulting.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef REPLACE_H
+#define REPLACE_H
+
+#include "copyright.h"
+
+class AddrSpace;
+
+class ReplacementPolicy {
+  public:
+    virtual ~ReplacementPolicy() {}
+
+    virtual char *Name() = 0;		// for the startup banner
+
+    virtual void PageIn(int pPage) {}	// "pPage" was just filled; the
+					// frame table says with what
+    virtual void PageFree(int pPage) {}	// "pPage" is about to be emptied
+    virtual int ChooseVictim(AddrSpace *space, int vPage,
+			     AddrSpace *owner) = 0;
+					// Pick a frame to empty, so that
+					// "vPage" of "space" can go there
+					// ("space" is NULL if it is to be
+					// left free); if "owner" isn't NULL,
+					// it must be one of owner's (-PFF)
+    virtual bool NeedsSampling() { return FALSE; }
+					// Should Sample be called on timer
+					// interrupts?
+    virtual void Sample() {}		// Look at (and clear) use bits
+    virtual bool RecentlyUsed(int pPage); // By the policy's lights, has
+					// "pPage" been used lately?  (By 
+					// default, is its use bit set?)
+};
+
+extern ReplacementPolicy *NewReplacementPolicy(int choice);
+					// The policy for -V "choice", or NULL
+					// if it means demand paging only
+
+// A doubly linked list of frames, by physical page number, for
+// policies that keep frames in some order and need to take one out
+// of the middle of it.  A frame is on at most one FrameList.
+
+class FrameList {
+  public:
+    FrameList(int *prevFrame, int *nextFrame);
+					// Make an empty list; the links are
+					// shared by all lists over the frames
+
+    void Append(int pPage);		// Put a frame at the end
+    void Remove(int pPage);		// Take a frame off, wherever it is
+    int First() { return first; }	// The frame at the front, or -1
+    int Next(int pPage) { return next[pPage]; }
+					// The one after "pPage", or -1
+    int Size() { return size; }
+
+  private:
+    int *prev, *next;			// links, indexed by physical page
+    int first, last;			// ends of the list, or -1
+    int size;
+};
+
+#endif // REPLACE_H
@@ -1,24 +1,205 @@
+// swap.cc
+//	Routines to manage the swap device.  See swap.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
 
+#include "copyright.h"
+#include "system.h"
+#include "swap.h"
+#include "sysdep.h"
 
-// #include "system.h"
-// #include "syscall.h"
-// #include "swap.h"
+//----------------------------------------------------------------------
+// SwapManager::SwapManager
+// 	Create the swap file (empty; it grows as slots are written) and
+//	open it for the lifetime of the kernel.
+//
+//	"fileName" -- the name to give the backing file
+//	"cacheBytes" -- the compressed cache's budget, or 0 for none
+//----------------------------------------------------------------------
 
-// Swap::Swap(int id, int pageNum){
-//     printf("doing file shit\n");
-// 	// Create swap file
-// 	sprintf(swapFileName, "%i.swap", currentThread->getID());
-// 	//Here, we create a swapFileName as ID.swap using unique thread ID
-// 	fileSystem->Create(swapFileName, size);
+SwapManager::SwapManager(char *fileName, int cacheBytes)
+{
+    name = fileName;
+    fd = OpenForWrite(name);
 
-// 	//Then, we must open it up.
-// 	swapFile = fileSystem->Open(swapFileName);
+    numSlots = InitialSwapSlots;
+    slotMap = new BitMap(numSlots);
+    holders = new int[numSlots];
+    inUse = 0;
+    cache = NULL;
+    if (cacheBytes > 0)
+	cache = new CompressedCache(cacheBytes);
+}
 
-//     MarkSwapped(pageNum, false);
-//     Swap::id = id;
-// }
-// Swap::~Swap(){
-//     delete swapFile;
-//     fileSystem->Remove(swapFileName);
-// }
+//----------------------------------------------------------------------
+// SwapManager::~SwapManager
+// 	Close the swap file and remove it; its contents are of no use
+//	once Nachos has halted.
+//----------------------------------------------------------------------
 
+SwapManager::~SwapManager()
+{
+    Close(fd);
+    Unlink(name);
+    delete slotMap;
+    delete [] holders;
+    delete cache;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Allocate
+// 	Reserve a slot and return its number, with one holder.  If all
+//	are taken, the slot map is doubled; the file itself just grows
+//	when the new slots are written.
+//----------------------------------------------------------------------
+
+int
+SwapManager::Allocate()
+{
+    int slot = slotMap->Find();
+
+    if (slot == -1) {
+	BitMap *bigger = new BitMap(numSlots * 2);
+	int *moreHolders = new int[numSlots * 2];
+
+	for (int i = 0; i < numSlots; i++) {
+	    bigger->Mark(i);		// they were all in use
+	    moreHolders[i] = holders[i];
+	}
+	delete slotMap;
+	delete [] holders;
+	slotMap = bigger;
+	holders = moreHolders;
+	numSlots *= 2;
+	slot = slotMap->Find();
+    }
+    holders[slot] = 1;
+    inUse++;
+    return slot;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Share
+// 	Another address space holds "slot" now, as well.
+//----------------------------------------------------------------------
+
+void
+SwapManager::Share(int slot)
+{
+    ASSERT(slotMap->Test(slot));
+    holders[slot]++;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Free
+// 	Give back a slot that is no longer needed; it is free once
+//	nobody holds it.
+//----------------------------------------------------------------------
+
+void
+SwapManager::Free(int slot)
+{
+    ASSERT(slotMap->Test(slot));
+    if (--holders[slot] > 0)
+	return;
+    if (cache != NULL)
+	cache->Drop(slot);
+    slotMap->Clear(slot);
+    inUse--;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::ReadPage
+// 	Read the page stored in a slot, from the compressed cache if it
+//	is there (where it stays, as the slot's contents).
+//
+//	"slot" -- where the page is
+//	"into" -- where to put it; PageSize bytes
+//----------------------------------------------------------------------
+
+void
+SwapManager::ReadPage(int slot, char *into)
+{
+    ASSERT(slotMap->Test(slot));
+    if (cache != NULL && cache->Get(slot, into)) {
+	stats->numCacheReads++;
+	return;
+    }
+    ReadSlot(slot, into);
+    stats->numSwapReads++;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::WritePage
+// 	Store a page in a slot: in the compressed cache, if it compresses
+//	well, pushing older pages out to the file to make room; if not, 
+//	in the file.
+//
+//	"slot" -- where to put it
+//	"from" -- the page; PageSize bytes
+//----------------------------------------------------------------------
+
+void
+SwapManager::WritePage(int slot, char *from)
+{
+    ASSERT(slotMap->Test(slot));
+    if (cache != NULL) {
+	cache->Drop(slot);		// it's out of date
+	if (cache->Compress(from)) {
+	    while (!cache->Fits())
+		PushOut();
+	    cache->Keep(slot);
+	    stats->numCacheWrites++;
+	    return;
+	}
+	stats->numCacheRejects++;
+    }
+    WriteSlot(slot, from);
+    stats->numSwapWrites++;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::PushOut
+// 	Make room in the compressed cache by writing the page that has
+//	been there longest without being read to its slot in the file.
+//----------------------------------------------------------------------
+
+void
+SwapManager::PushOut()
+{
+    char *page = new char[PageSize];
+    int slot = cache->Oldest();
+
+    ASSERT(slot != -1);
+    cache->Get(slot, page);
+    cache->Drop(slot);
+    WriteSlot(slot, page);
+    delete [] page;
+    stats->numSwapWrites++;
+    stats->numCachePushOuts++;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::ReadSlot, WriteSlot
+// 	Read or write a whole page at its slot in the file.  A short
+//	read or write means swap is broken, so we stop.
+//----------------------------------------------------------------------
+
+void
+SwapManager::ReadSlot(int slot, char *into)
+{
+    int numRead;
+
+    Lseek(fd, slot * PageSize, 0);
+    numRead = ReadPartial(fd, into, PageSize);
+    ASSERT(numRead == PageSize);
+}
+
+void
+SwapManager::WriteSlot(int slot, char *from)
+{
+    Lseek(fd, slot * PageSize, 0);
+    WriteFile(fd, from, PageSize);	// checks it was all written
+}
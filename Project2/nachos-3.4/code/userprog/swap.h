@@ -1,21 +1,70 @@
+// swap.h
+//	Data structures for managing the swap device: one backing file,
+//	shared by every address space, divided into page-sized slots.
+//
+//	The file is created and opened once when Nachos starts, and
+//	removed when it halts, so paging does not have to open and
+//	close a file on every fault.  Like the simulated disk, it is a
+//	UNIX file, whichever file system Nachos is built with: files in
+//	the Nachos file system have a fixed size, of at most MaxFileSize
+//	bytes, which is far too small.  Slots are handed out with a bitmap;
+//	each AddrSpace remembers which slot holds each of its pages (see
+//	AddrSpace::swapSlot) and gives them back when it is destroyed.
+//
+//	After a Fork, parent and child hold the same slots for the pages
+//	that were swapped out, so each slot has a count of its holders,
+//	and is only really freed when the last one gives it back.  A
+//	shared slot must not be written; see AddrSpace::PrivateSlot.
+//
+//	With -Z, pages written to swap are kept compressed in memory if
+//	they compress well, and only go to the file when the cache needs
+//	the room; see zcache.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
 
-// #include "openfile.h"
-
-// class Swap{
-//     public:
-//         Swap(int id, int pageNum);
-//         ~Swap();
-
-//         bool HasBeenSwapped(int p){
-//             return swaps[p];
-//         }
-//         void MarkSwapped(int pageNum, bool val){
-//             swaps[pageNum] == val;
-//         }
-
-//     private:
-//         int id;
-//         OpenFile *swapFile;
-//         char swapFileName[12];
-//         bool *swaps;
-// };
\ No newline at end of file
+#ifndef SWAP_H
+#define SWAP_H
+
+#include "copyright.h"
+#include "bitmap.h"
+#include "zcache.h"
+
+#define SwapFileName	"SWAP"	// the backing file, in the current directory
+#define InitialSwapSlots 256	// the slot map grows beyond this as needed
+
+class SwapManager {
+  public:
+    SwapManager(char *fileName, int cacheBytes);
+					// Create and open the swap file, 
+					// with a compressed cache of
+					// "cacheBytes" in front of it, if
+					// that isn't 0
+    ~SwapManager();			// Close and remove it
+
+    int Allocate();			// Reserve a free slot, and return it
+    void Share(int slot);		// One more holder for a slot
+    void Free(int slot);		// Give a slot back
+    bool IsShared(int slot) { return holders[slot] > 1; }
+
+    void ReadPage(int slot, char *into); // Read one page from a slot
+    void WritePage(int slot, char *from); // Write one page to a slot
+
+    int NumInUse() { return inUse; }	// Slots currently reserved
+
+  private:
+    char *name;				// the backing file's name
+    int fd;				// ... kept open the whole time
+    BitMap *slotMap;			// which slots are in use
+    int *holders;			// how many hold each slot
+    int numSlots;			// number of bits in slotMap
+    int inUse;				// number of bits set in slotMap
+    CompressedCache *cache;		// pages kept in memory, or NULL
+    void PushOut();			// write the cache's oldest page to
+					// the file, to make room
+    void ReadSlot(int slot, char *into);	// a page from the file
+    void WriteSlot(int slot, char *from);	// ... and to it
+};
+
+#endif // SWAP_H
@@ -110,14 +110,16 @@ void Close(OpenFileId id);
 
 
 
-/* User-level thread operations: Fork and Yield.  To allow multiple
- * threads to run within a user program. 
+/* Process and thread operations: Fork and Yield.
  */
 
-/* Fork a thread to run a procedure ("func") in the *same* address space 
- * as the current thread.
+/* Fork a new process in a *copy* of the current process's address 
+ * space, taken as it is now (stack included).  The copy shares the 
+ * pages until one process or the other writes one.  Both processes go
+ * on from the call to Fork, which returns 0 in the new process, and the
+ * new process's id in the caller.
  */
-void Fork(void (*func)());
+SpaceId Fork();
 
 /* Yield the CPU to another runnable thread, whether in this address space 
  * or not. 
@@ -0,0 +1,152 @@
+// textcache.cc
+//	Routines to keep track of the text pages that address spaces
+//	running the same program share.  See textcache.h.
+//
+//	Mapping and unmapping the frames themselves is up to AddrSpace.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "textcache.h"
+
+//----------------------------------------------------------------------
+// SharedText::SharedText
+// 	Keep track of the text pages of the program in "fileName":
+//	"count" of them, from virtual page "first" on.  None are in
+//	memory yet, and no space is running it.
+//----------------------------------------------------------------------
+
+SharedText::SharedText(char *fileName, int first, int count)
+{
+    name = new char[strlen(fileName) + 1];
+    strcpy(name, fileName);
+    firstPage = first;
+    numPages = count;
+    frame = new int[count > 0 ? count : 1];
+    for (int i = 0; i < count; i++)
+	frame[i] = -1;
+    maxUsers = 4;
+    users = new AddrSpace *[maxUsers];
+    numUsers = 0;
+    next = NULL;
+}
+
+SharedText::~SharedText()
+{
+    delete [] name;
+    delete [] frame;
+    delete [] users;
+}
+
+//----------------------------------------------------------------------
+// SharedText::AddUser, RemoveUser
+// 	Add an address space to the ones running the program, making
+//	room if need be, or take one off.
+//----------------------------------------------------------------------
+
+void
+SharedText::AddUser(AddrSpace *space)
+{
+    if (numUsers == maxUsers) {
+	AddrSpace **bigger = new AddrSpace *[maxUsers * 2];
+
+	for (int i = 0; i < numUsers; i++)
+	    bigger[i] = users[i];
+	delete [] users;
+	users = bigger;
+	maxUsers *= 2;
+    }
+    users[numUsers++] = space;
+}
+
+void
+SharedText::RemoveUser(AddrSpace *space)
+{
+    for (int i = 0; i < numUsers; i++)
+	if (users[i] == space) {
+	    users[i] = users[--numUsers];
+	    return;
+	}
+    ASSERT(FALSE);
+}
+
+//----------------------------------------------------------------------
+// SharedText::Matches
+// 	Is this the text of the program in "fileName", laid out the
+//	same way?
+//----------------------------------------------------------------------
+
+bool
+SharedText::Matches(char *fileName, int first, int count)
+{
+    return !strcmp(name, fileName) && firstPage == first && numPages == count;
+}
+
+//----------------------------------------------------------------------
+// TextCache::TextCache, ~TextCache
+// 	The cache starts empty.  Nachos may halt with programs still
+//	running, so there may be some left when it is deleted.
+//----------------------------------------------------------------------
+
+TextCache::TextCache()
+{
+    texts = NULL;
+}
+
+TextCache::~TextCache()
+{
+    while (texts != NULL) {
+	SharedText *text = texts;
+
+	texts = text->next;
+	delete text;
+    }
+}
+
+//----------------------------------------------------------------------
+// TextCache::Attach
+// 	Return the SharedText for the program in "fileName", whose text
+//	is "numPages" pages from "firstPage" on, making it if no other
+//	space is running the program; "space" is added to its users.
+//----------------------------------------------------------------------
+
+SharedText *
+TextCache::Attach(char *fileName, int firstPage, int numPages,
+		  AddrSpace *space)
+{
+    SharedText *text;
+
+    for (text = texts; text != NULL; text = text->next)
+	if (text->Matches(fileName, firstPage, numPages))
+	    break;
+    if (text == NULL) {
+	text = new SharedText(fileName, firstPage, numPages);
+	text->next = texts;
+	texts = text;
+    }
+    text->AddUser(space);
+    return text;
+}
+
+//----------------------------------------------------------------------
+// TextCache::Detach
+// 	"space" is done with the program; once nobody is running it,
+//	forget it.  The space must already have given up its frames.
+//----------------------------------------------------------------------
+
+void
+TextCache::Detach(SharedText *text, AddrSpace *space)
+{
+    SharedText **prev;
+
+    text->RemoveUser(space);
+    if (text->NumUsers() > 0)
+	return;
+    for (prev = &texts; *prev != text; prev = &(*prev)->next)
+	;
+    *prev = text->next;
+    delete text;
+}
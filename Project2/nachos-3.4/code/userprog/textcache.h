@@ -0,0 +1,83 @@
+// textcache.h
+//	Data structures for sharing the text (code) pages of a program
+//	among the address spaces running it.
+//
+//	A page that lies wholly inside the code segment is never written,
+//	so once it is in memory, any other space running the same program
+//	can map that frame rather than read in a copy of its own.  The
+//	TextCache keeps a SharedText for each program in use, found by
+//	the name it was opened with, which says which frame holds each of
+//	its text pages; it goes away with the last space running it.
+//
+//	A shared frame is charged to one of those spaces (the space in its
+//	FrameEntry), and the replacement policy treats it like any of that
+//	space's pages.  Evicting it unmaps it from every space that has
+//	it; text is never dirty, so nothing is written.  When the space it
+//	is charged to goes away, another space that has it mapped takes
+//	it over, and it is only freed when there is none.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include "copyright.h"
+
+class AddrSpace;
+
+class SharedText {
+  public:
+    SharedText(char *fileName, int first, int count);
+					// Text pages "first" on, "count" of
+					// them, with none in memory yet
+    ~SharedText();
+
+    bool IsText(int vPage)		// can the page be shared?
+	{ return vPage >= firstPage && vPage < firstPage + numPages; }
+    int FirstPage() { return firstPage; }
+    int Frame(int vPage) { return frame[vPage - firstPage]; }
+					// the frame holding it, or -1
+    void SetFrame(int vPage, int pPage) { frame[vPage - firstPage] = pPage; }
+
+    void AddUser(AddrSpace *space);	// "space" is running the program
+    void RemoveUser(AddrSpace *space);	// ... and now it isn't
+    int NumUsers() { return numUsers; }
+    AddrSpace *User(int i) { return users[i]; }
+
+    bool Matches(char *fileName, int first, int count);
+					// the same program?
+    char *Name() { return name; }
+
+    SharedText *next;			// the next one in the cache
+
+  private:
+    char *name;				// the executable's file name
+    int firstPage;			// first virtual page of text
+    int numPages;			// how many there are
+    int *frame;				// frame holding each, or -1
+    AddrSpace **users;			// spaces running the program
+    int numUsers;			// entries used in "users"
+    int maxUsers;			// ... and its size
+};
+
+class TextCache {
+  public:
+    TextCache();			// Start with no programs
+    ~TextCache();
+
+    SharedText *Attach(char *fileName, int firstPage, int numPages,
+		       AddrSpace *space);
+					// Find (or make) the program's
+					// SharedText, and add "space" to
+					// its users
+    void Detach(SharedText *text, AddrSpace *space);
+					// Take "space" off its users,
+					// deleting it once it has none
+
+  private:
+    SharedText *texts;			// the programs in use
+};
+
+#endif // TEXTCACHE_H
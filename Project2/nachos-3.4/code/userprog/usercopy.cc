@@ -0,0 +1,154 @@
+// usercopy.cc
+//	Routines for copying system call arguments and results between
+//	the kernel and the running user program's address space.
+//
+//	Each copy is split at page boundaries; for every page touched
+//	we find its frame through the page table (faulting it in first
+//	if need be), set the use and dirty bits the way the hardware
+//	would, and copy that part of the range in one go.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "addrspace.h"
+#include "usercopy.h"
+
+//----------------------------------------------------------------------
+// UserFrame
+// 	Return where in mainMemory a virtual page of the running user
+//	program is, bringing it in with AddrSpace::HandlePageFault if
+//	it isn't there, or copying it if we want to write it and it is
+//	shared after a Fork.  Returns NULL if the page is outside the
+//	address space, or read-only and we want to write it.
+//
+//	"userAddr" -- any address on the page
+//	"writing" -- TRUE if the page is about to be modified
+//----------------------------------------------------------------------
+
+static char *
+UserFrame(int userAddr, bool writing)
+{
+    AddrSpace *space = currentThread->space;
+    int vPage = (unsigned) userAddr / PageSize;
+    TranslationEntry *entry;
+
+    if (vPage >= (int) space->numPages)
+	return NULL;
+    entry = space->getEntry(vPage);
+    if (entry == NULL || !entry->valid) {
+	faultcount++;
+	space->HandlePageFault(vPage * PageSize);
+	entry = space->getEntry(vPage);
+    }
+    if (writing && entry->readOnly) {
+	if (!space->CopyOnWrite(vPage * PageSize))
+	    return NULL;
+	entry = space->getEntry(vPage);
+    }
+
+    // a copy of the entry in the TLB gets these too, when it's written back
+    entry->use = TRUE;
+    if (writing)
+	entry->dirty = TRUE;
+    return machine->mainMemory + entry->physicalPage * PageSize;
+}
+
+//----------------------------------------------------------------------
+// CopyIn
+// 	Copy "size" bytes at "userAddr" in the user program into the
+//	kernel's "buffer".  Returns FALSE if some of the range is outside
+//	the address space.
+//----------------------------------------------------------------------
+
+bool
+CopyIn(int userAddr, char *buffer, int size)
+{
+    while (size > 0) {
+	int offset = (unsigned) userAddr % PageSize;
+	int chunk = min(size, PageSize - offset);
+	char *frame = UserFrame(userAddr, FALSE);
+
+	if (frame == NULL)
+	    return FALSE;
+	memcpy(buffer, frame + offset, chunk);
+	userAddr += chunk;
+	buffer += chunk;
+	size -= chunk;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// CopyOut
+// 	Copy "size" bytes from the kernel's "buffer" to "userAddr" in the
+//	user program.  Returns FALSE if some of the range is outside the
+//	address space or read-only; anything before that is copied.
+//----------------------------------------------------------------------
+
+bool
+CopyOut(int userAddr, char *buffer, int size)
+{
+    while (size > 0) {
+	int offset = (unsigned) userAddr % PageSize;
+	int chunk = min(size, PageSize - offset);
+	char *frame = UserFrame(userAddr, TRUE);
+	int physAddr;
+
+	if (frame == NULL)
+	    return FALSE;
+	memcpy(frame + offset, buffer, chunk);
+
+	// the simulator may have decoded some of these bytes as code
+	physAddr = frame + offset - machine->mainMemory;
+	for (int i = physAddr & ~3; i < physAddr + chunk; i += 4)
+	    machine->NoteWrite(i);
+
+	userAddr += chunk;
+	buffer += chunk;
+	size -= chunk;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// CopyInString
+// 	Copy the null-terminated string at "userAddr" in the user program
+//	into the kernel's "buffer", which holds "maxSize" bytes.  A
+//	string that doesn't fit is cut short; "buffer" is always null
+//	terminated.
+//
+//	Returns the length of the string copied, or -1 if it runs off
+//	the end of the address space.
+//----------------------------------------------------------------------
+
+int
+CopyInString(int userAddr, char *buffer, int maxSize)
+{
+    int length = 0;
+
+    ASSERT(maxSize > 0);
+    while (length < maxSize - 1) {
+	int offset = (unsigned) userAddr % PageSize;
+	int chunk = min(maxSize - 1 - length, PageSize - offset);
+	char *frame = UserFrame(userAddr, FALSE);
+	char *end;
+
+	if (frame == NULL) {
+	    buffer[length] = '\0';
+	    return -1;
+	}
+	end = (char *) memchr(frame + offset, '\0', chunk);
+	if (end != NULL)
+	    chunk = end - (frame + offset);
+	memcpy(buffer + length, frame + offset, chunk);
+	length += chunk;
+	if (end != NULL)
+	    break;
+	userAddr += chunk;
+    }
+    buffer[length] = '\0';
+    return length;
+}
@@ -0,0 +1,33 @@
+// usercopy.h
+//	Routines for moving data between the kernel and the address
+//	space of the running user program, for system calls that take
+//	pointers to strings or buffers.
+//
+//	Rather than going through Machine::ReadMem/WriteMem a byte at a
+//	time, each routine looks up the page table once per page and
+//	copies whole chunks straight out of (or into) mainMemory.  Pages
+//	that aren't resident are faulted in on the spot, so the system
+//	call never has to be restarted.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef USERCOPY_H
+#define USERCOPY_H
+
+#include "copyright.h"
+
+extern bool CopyIn(int userAddr, char *buffer, int size);
+					// Copy "size" bytes from user memory;
+					// FALSE if the range isn't all mapped
+extern bool CopyOut(int userAddr, char *buffer, int size);
+					// Copy "size" bytes to user memory;
+					// FALSE if the range isn't all writable
+extern int CopyInString(int userAddr, char *buffer, int maxSize);
+					// Copy a null-terminated string from
+					// user memory, truncating it to fit in
+					// "maxSize" bytes.  Returns its length,
+					// or -1 on a bad address.
+
+#endif // USERCOPY_H
@@ -0,0 +1,354 @@
+// zcache.cc
+//	Routines for the compressed page cache (-Z).  See zcache.h.
+//
+//	A compressed page is a sequence of runs, each starting with a
+//	control byte c:
+//
+//	c < 0x80 -- c+1 literal bytes follow
+//	0x80 <= c < 0xc0 -- copy (c & 0x3f) + MinMatch bytes, starting the
+//		number of bytes back given by the next byte, plus one; the
+//		copy may overlap what it is copying, to repeat a byte or word
+//	c >= 0xc0 -- (c & 0x3f) + 1 words follow, as their first two bytes;
+//		the other two are zero (small integers, on our little-endian
+//		machine)
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "zcache.h"
+
+//----------------------------------------------------------------------
+// LongestMatch
+// 	How long a copy, up to MaxMatch bytes, can be made of what is at
+//	"in" in the page at "from", from up to 256 bytes before it?  Set
+//	"*distance" to how far back it is from.
+//----------------------------------------------------------------------
+
+static int
+LongestMatch(unsigned char *from, int in, int *distance)
+{
+    int bestLength = 0;
+
+    *distance = 0;
+    for (int back = 1; back <= min(in, 256); back++) {
+	int length = 0;
+
+	while (length < MaxMatch && in + length < PageSize
+		&& from[in + length - back] == from[in + length])
+	    length++;
+	if (length > bestLength) {
+	    bestLength = length;
+	    *distance = back;
+	}
+    }
+    return bestLength;
+}
+
+//----------------------------------------------------------------------
+// ShortWords
+// 	How many words, up to MaxShortWords, from "in" on in the page at
+//	"from" have zero upper halves?  None unless "in" is word-aligned.
+//
+//	The run stops at a word where a copy of two words or more could
+//	start instead: the copy takes two bytes, the words four or more.
+//	Otherwise a page of zeros would go as one long run of words.
+//----------------------------------------------------------------------
+
+static int
+ShortWords(unsigned char *from, int in)
+{
+    int words = 0, distance;
+
+    if (in % 4 != 0)
+	return 0;
+    while (words < MaxShortWords && in + 4 * words < PageSize
+	    && from[in + 4 * words + 2] == 0 && from[in + 4 * words + 3] == 0) {
+	if (words > 0 && LongestMatch(from, in + 4 * words, &distance) >= 8)
+	    break;
+	words++;
+    }
+    return words;
+}
+
+//----------------------------------------------------------------------
+// CompressPage
+// 	Compress the PageSize bytes at "from" into "to", taking at each
+//	point the longest copy or run of short words found, whichever 
+//	saves more, and return the compressed size; or -1 if it would be
+//	more than "limit" bytes.
+//----------------------------------------------------------------------
+
+static int
+CompressPage(unsigned char *from, unsigned char *to, int limit)
+{
+    int in = 0, out = 0;
+    int literals = 0;			// bytes before "in" not yet written
+
+    while (in < PageSize) {
+	int bestDistance;
+	int bestLength = LongestMatch(from, in, &bestDistance);
+	int shortWords = ShortWords(from, in);
+
+	if (bestLength < MinMatch)
+	    bestLength = 0;
+	if (shortWords < 2 || 2 * shortWords - 1 <= bestLength - 2)
+	    shortWords = 0;		// not worth it, or the copy is better
+	if (bestLength == 0 && shortWords == 0) {
+	    in++;
+	    literals++;
+	    if (literals < MaxLiteral && in < PageSize)
+		continue;
+	}
+	if (literals > 0) {
+	    if (out + 1 + literals > limit)
+		return -1;
+	    to[out++] = literals - 1;
+	    memcpy(to + out, from + in - literals, literals);
+	    out += literals;
+	    literals = 0;
+	}
+	if (shortWords > 0) {
+	    if (out + 1 + 2 * shortWords > limit)
+		return -1;
+	    to[out++] = 0xc0 | (shortWords - 1);
+	    for (; shortWords > 0; shortWords--, in += 4) {
+		to[out++] = from[in];
+		to[out++] = from[in + 1];
+	    }
+	} else if (bestLength > 0) {
+	    if (out + 2 > limit)
+		return -1;
+	    to[out++] = 0x80 | (bestLength - MinMatch);
+	    to[out++] = bestDistance - 1;
+	    in += bestLength;
+	}
+    }
+    return out;
+}
+
+//----------------------------------------------------------------------
+// DecompressPage
+// 	Undo CompressPage: fill the PageSize bytes at "to" from the 
+//	"size" compressed bytes at "from".
+//----------------------------------------------------------------------
+
+static void
+DecompressPage(unsigned char *from, int size, unsigned char *to)
+{
+    int in = 0, out = 0;
+
+    while (out < PageSize) {
+	int c = from[in++];
+
+	if (c < 0x80) {
+	    memcpy(to + out, from + in, c + 1);
+	    in += c + 1;
+	    out += c + 1;
+	} else if (c < 0xc0) {
+	    int length = (c & 0x3f) + MinMatch;
+	    int distance = from[in++] + 1;
+
+	    for (; length > 0; length--, out++)
+		to[out] = to[out - distance];
+	} else {
+	    for (int words = (c & 0x3f) + 1; words > 0; words--) {
+		to[out++] = from[in++];
+		to[out++] = from[in++];
+		to[out++] = 0;
+		to[out++] = 0;
+	    }
+	}
+    }
+    ASSERT(in == size && out == PageSize);
+}
+
+//----------------------------------------------------------------------
+// CompressedCache::CompressedCache
+// 	Start out empty, with room for "maxBytes" bytes of compressed
+//	pages.
+//----------------------------------------------------------------------
+
+CompressedCache::CompressedCache(int maxBytes)
+{
+    budget = maxBytes;
+    used = 0;
+    oldest = NULL;
+    buffer = new char[MaxStored];
+    length = -1;
+}
+
+CompressedCache::~CompressedCache()
+{
+    while (oldest != NULL) {
+	CachedPage *page = oldest;
+
+	oldest = page->next;
+	delete [] page->data;
+	delete page;
+    }
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// CompressedCache::Compress
+// 	Compress "page" into our buffer, for Keep.  Return FALSE if it
+//	comes to more than MaxStored bytes, or more than we can hold.
+//----------------------------------------------------------------------
+
+bool
+CompressedCache::Compress(char *page)
+{
+    length = CompressPage((unsigned char *) page, (unsigned char *) buffer,
+			  MaxStored);
+    return length != -1 && length <= budget;
+}
+
+//----------------------------------------------------------------------
+// CompressedCache::Fits
+// 	Can we hold the page just compressed without pushing others out?
+//----------------------------------------------------------------------
+
+bool
+CompressedCache::Fits()
+{
+    return used + length <= budget;
+}
+
+//----------------------------------------------------------------------
+// CompressedCache::Keep
+// 	Hold the page just compressed, as the most recently used, as what
+//	is in swap slot "slot"; it replaces anything we had for the slot.
+//----------------------------------------------------------------------
+
+void
+CompressedCache::Keep(int slot)
+{
+    CachedPage *page = new CachedPage, **last;
+
+    ASSERT(length != -1);
+    Drop(slot);
+    page->slot = slot;
+    page->size = length;
+    page->data = new char[length];
+    memcpy(page->data, buffer, length);
+    page->next = NULL;
+    for (last = &oldest; *last != NULL; last = &(*last)->next)
+	;
+    *last = page;
+    used += length;
+    length = -1;
+}
+
+//----------------------------------------------------------------------
+// CompressedCache::Get
+// 	If we have the page in swap slot "slot", decompress it into
+//	"into", make it the most recently used, and return TRUE.
+//----------------------------------------------------------------------
+
+bool
+CompressedCache::Get(int slot, char *into)
+{
+    CachedPage **prev, **last;
+    CachedPage *page = Find(slot, &prev);
+
+    if (page == NULL)
+	return FALSE;
+    DecompressPage((unsigned char *) page->data, page->size,
+		   (unsigned char *) into);
+    *prev = page->next;			// move it to the end
+    for (last = prev; *last != NULL; last = &(*last)->next)
+	;
+    *last = page;
+    page->next = NULL;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// CompressedCache::Drop
+// 	Forget the page in swap slot "slot", if we have it.
+//----------------------------------------------------------------------
+
+void
+CompressedCache::Drop(int slot)
+{
+    CachedPage **prev;
+    CachedPage *page = Find(slot, &prev);
+
+    if (page == NULL)
+	return;
+    *prev = page->next;
+    used -= page->size;
+    delete [] page->data;
+    delete page;
+}
+
+//----------------------------------------------------------------------
+// CompressedCache::Oldest
+// 	Return the slot of the page used least recently, or -1 if we
+//	have none.
+//----------------------------------------------------------------------
+
+int
+CompressedCache::Oldest()
+{
+    return oldest == NULL ? -1 : oldest->slot;
+}
+
+//----------------------------------------------------------------------
+// CompressedCache::Find
+// 	Return the page we have for "slot", or NULL, and set "*prevp" to
+//	the link that points to it.
+//----------------------------------------------------------------------
+
+CachedPage *
+CompressedCache::Find(int slot, CachedPage ***prevp)
+{
+    CachedPage **prev;
+
+    for (prev = &oldest; *prev != NULL; prev = &(*prev)->next)
+	if ((*prev)->slot == slot)
+	    break;
+    *prevp = prev;
+    return *prev;
+}
+
+//----------------------------------------------------------------------
+// CompressTest
+// 	Check that pages of several kinds come back from DecompressPage
+//	just as they went into CompressPage, and print how small each
+//	got.  Invoked by "nachos -ZT".
+//----------------------------------------------------------------------
+
+void
+CompressTest()
+{
+    static char *kinds[] = { "zeros", "small integers", "one word repeated",
+			     "small integers, then zeros", "random bytes" };
+    unsigned char *page = new unsigned char[PageSize];
+    unsigned char *packed = new unsigned char[2 * PageSize];
+    unsigned char *back = new unsigned char[PageSize];
+
+    for (int kind = 0; kind < 5; kind++) {
+	int size;
+
+	for (int i = 0; i < PageSize; i++)
+	    switch (kind) {
+	      case 0: page[i] = 0; break;
+	      case 1: page[i] = (i % 4 == 0) ? i / 4 : 0; break;
+	      case 2: page[i] = "\x78\x56\x34\x12"[i % 4]; break;
+	      case 3: page[i] = (i % 4 == 0 && i < PageSize / 2) ? i : 0; break;
+	      default: page[i] = Random(); break;
+	    }
+	size = CompressPage(page, packed, 2 * PageSize);
+	ASSERT(size > 0);
+	DecompressPage(packed, size, back);
+	ASSERT(memcmp(page, back, PageSize) == 0);
+	printf("%s: %d bytes compress to %d\n", kinds[kind], PageSize, size);
+    }
+    delete [] page;
+    delete [] packed;
+    delete [] back;
+}
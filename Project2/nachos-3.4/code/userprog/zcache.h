@@ -0,0 +1,74 @@
+// zcache.h
+//	Data structures for the compressed page cache (-Z): kernel memory
+//	in front of the swap file, where pages written to swap are kept
+//	compressed, so that reading them back needs no swap I/O, and 
+//	many never have to be written to the file at all.
+//
+//	User pages are mostly zeros and small integers, so they are
+//	compressed with a simple LZ77 scheme -- runs of literal bytes,
+//	and copies of up to MaxMatch bytes from as far back as the start
+//	of the page, where a copy from just before itself is a run of
+//	the same byte or word -- plus runs of words whose upper halves
+//	are zero, stored as their lower halves.  A page that doesn't
+//	shrink to MaxStored bytes, three quarters of a page, or less
+//	isn't worth keeping, and goes to the file.
+//
+//	The cache holds at most "maxBytes" bytes of compressed pages, by
+//	swap slot.  When a page doesn't fit, the least recently used are
+//	pushed out to make room, and SwapManager writes them to their 
+//	slots in the file.  See SwapManager::WritePage.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ZCACHE_H
+#define ZCACHE_H
+
+#include "copyright.h"
+
+#define MaxStored	(PageSize * 3 / 4)	// the most a page may take up
+#define MaxLiteral	128		// literal bytes per run, at most
+#define MinMatch	3		// shortest copy worth encoding
+#define MaxMatch	66		// ... and the longest
+#define MaxShortWords	64		// half-words per run, at most
+
+// One compressed page.
+
+class CachedPage {
+  public:
+    int slot;				// the swap slot it belongs in
+    char *data;				// its compressed bytes
+    int size;				// ... and how many there are
+    CachedPage *next;			// the next more recently used
+};
+
+class CompressedCache {
+  public:
+    CompressedCache(int maxBytes);	// Hold up to "maxBytes" bytes
+    ~CompressedCache();
+
+    bool Compress(char *page);		// Compress a page, keeping the 
+					// result for Keep; FALSE if it isn't
+					// worth keeping
+    bool Fits();			// Is there room for it?
+    void Keep(int slot);		// Keep it, as the page in "slot"
+
+    bool Get(int slot, char *into);	// Decompress the page in "slot",
+					// if it is here
+    void Drop(int slot);		// Forget the page in "slot"
+    int Oldest();			// The slot of the least recently
+					// used page, or -1 if empty
+
+  private:
+    CachedPage *Find(int slot, CachedPage ***prevp);
+					// the page kept for "slot", and
+					// the link to it, or NULL
+    int budget;				// bytes we may hold
+    int used;				// ... and hold now
+    CachedPage *oldest;			// pages, least recently used first
+    char *buffer;			// the last page compressed
+    int length;				// ... and its size
+};
+
+#endif // ZCACHE_H